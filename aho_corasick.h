@@ -0,0 +1,160 @@
+/**
+ * @file aho_corasick.h
+ * @brief Aho-Corasick automaton for searching several patterns in one pass
+ *
+ * The patterns are compiled into a deterministic automaton that reads each
+ * byte of the text exactly once, so the cost of checking a decrypted
+ * candidate does not grow with the number of patterns. To keep the
+ * transition table small, bytes are first mapped to classes: every byte
+ * that occurs in some pattern gets its own class and all other bytes share
+ * class 0.
+ */
+
+#ifndef AHO_CORASICK_H
+#define AHO_CORASICK_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Largest number of patterns (one bit of a 64-bit mask each) */
+#define AC_MAX_PATTERNS 64
+
+/**
+ * @brief Compiled set of patterns
+ */
+typedef struct {
+    int nstates;           /**< Number of automaton states (state 0 is the root) */
+    int nclasses;          /**< Number of byte classes */
+    unsigned char cls[256]; /**< Byte class of every byte value */
+    int *delta;            /**< Transition table, nstates x nclasses */
+    uint64_t *out;         /**< Patterns ending at each state, as a bit mask */
+    uint64_t all;          /**< Mask with one bit per pattern */
+} AcAutomaton;
+
+/**
+ * @brief Compiles patterns into an automaton
+ *
+ * @param ac Automaton to build
+ * @param patterns Patterns to search for
+ * @param lens Length of each pattern
+ * @param count Number of patterns (1..AC_MAX_PATTERNS)
+ * @return 1 on success, 0 on allocation failure or too many patterns
+ */
+static inline int acInit(AcAutomaton *ac, const char *const *patterns, const int *lens, int count){
+    int max_states = 1;
+    memset(ac, 0, sizeof(*ac));
+    if(count < 1 || count > AC_MAX_PATTERNS){
+        return 0;
+    }
+
+    ac->nclasses = 1;
+    for(int p = 0; p < count; p++){
+        max_states += lens[p];
+        for(int i = 0; i < lens[p]; i++){
+            unsigned char c = patterns[p][i];
+            if(ac->cls[c] == 0){
+                ac->cls[c] = ac->nclasses++;
+            }
+        }
+    }
+
+    ac->delta = (int *)malloc(sizeof(int) * max_states * ac->nclasses);
+    ac->out = (uint64_t *)calloc(max_states, sizeof(uint64_t));
+    int *fail = (int *)malloc(sizeof(int) * max_states);
+    int *queue = (int *)malloc(sizeof(int) * max_states);
+    if(!ac->delta || !ac->out || !fail || !queue){
+        free(fail);
+        free(queue);
+        return 0;
+    }
+
+    // Trie of the patterns; -1 marks a missing edge
+    for(int i = 0; i < max_states * ac->nclasses; i++){
+        ac->delta[i] = -1;
+    }
+    ac->nstates = 1;
+    for(int p = 0; p < count; p++){
+        int s = 0;
+        for(int i = 0; i < lens[p]; i++){
+            int *edge = &ac->delta[s * ac->nclasses + ac->cls[(unsigned char)patterns[p][i]]];
+            if(*edge < 0){
+                *edge = ac->nstates++;
+            }
+            s = *edge;
+        }
+        ac->out[s] |= (uint64_t)1 << p;
+    }
+    ac->all = (count == 64) ? ~(uint64_t)0 : ((uint64_t)1 << count) - 1;
+
+    // Breadth-first pass: fill missing edges from the failure state, so
+    // every transition becomes a single table lookup
+    int head = 0, tail = 0;
+    for(int c = 0; c < ac->nclasses; c++){
+        int *edge = &ac->delta[c];
+        if(*edge < 0){
+            *edge = 0;
+        } else {
+            fail[*edge] = 0;
+            queue[tail++] = *edge;
+        }
+    }
+    while(head < tail){
+        int s = queue[head++];
+        ac->out[s] |= ac->out[fail[s]];
+        for(int c = 0; c < ac->nclasses; c++){
+            int *edge = &ac->delta[s * ac->nclasses + c];
+            int via_fail = ac->delta[fail[s] * ac->nclasses + c];
+            if(*edge < 0){
+                *edge = via_fail;
+            } else {
+                fail[*edge] = via_fail;
+                queue[tail++] = *edge;
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+    return 1;
+}
+
+/**
+ * @brief Releases the tables of an automaton
+ */
+static inline void acFree(AcAutomaton *ac){
+    free(ac->delta);
+    free(ac->out);
+    ac->delta = NULL;
+    ac->out = NULL;
+}
+
+/**
+ * @brief Scans a buffer for the patterns
+ *
+ * @param ac Compiled automaton
+ * @param text Buffer to scan (NUL bytes are ordinary characters)
+ * @param n Length of the buffer
+ * @param need Patterns that must all be seen (ac->all for AND semantics),
+ *             or 0 to stop at the first occurrence of any pattern (OR)
+ * @return Offset just past the occurrence that satisfied the condition, or -1
+ */
+static inline int acScan(const AcAutomaton *ac, const unsigned char *text, int n, uint64_t need){
+    const int *delta = ac->delta;
+    int ncls = ac->nclasses;
+    uint64_t seen = 0;
+    int s = 0;
+
+    for(int i = 0; i < n; i++){
+        s = delta[s * ncls + ac->cls[text[i]]];
+        if(ac->out[s]){
+            seen |= ac->out[s];
+            if((seen & need) == need){
+                return i + 1;
+            }
+        }
+    }
+    return -1;
+}
+
+#endif /* AHO_CORASICK_H */
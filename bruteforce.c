@@ -15,6 +15,7 @@
 #include <mpi.h>
 #include <unistd.h>
 #include <rpc/des_crypt.h>
+#include "matcher.h"
 
 /**
  * @brief Decrypts ciphertext using DES algorithm
@@ -59,6 +60,9 @@ void encrypt(long key, char *ciph, int len){
 /** Search pattern to identify successful decryption */
 char search[] = " the ";
 
+/** Matcher for the search pattern, built once in main */
+Matcher matcher;
+
 /**
  * @brief Tests if a key successfully decrypts the ciphertext
  *
@@ -71,11 +75,10 @@ char search[] = " the ";
  * @return 1 if the decrypted text contains the search pattern, 0 otherwise
  */
 int tryKey(long key, char *ciph, int len){
-  char temp[len+1];
+  char temp[len];
   memcpy(temp, ciph, len);
-  temp[len]=0;
   decrypt(key, temp, len);
-  return strstr((char *)temp, search) != NULL;
+  return matcherContains(&matcher, (unsigned char *)temp, len);
 }
 
 /** Hardcoded encrypted message to crack */
@@ -106,6 +109,7 @@ int main(int argc, char *argv[]){
   MPI_Init(NULL, NULL);
   MPI_Comm_size(comm, &N);
   MPI_Comm_rank(comm, &id);
+  matcherInit(&matcher, search, strlen(search));
 
   // Divide keyspace among processes
   int range_per_node = upper / N;
@@ -0,0 +1,242 @@
+/**
+ * @file checkpoint.h
+ * @brief Sets of searched key intervals and their checkpoint files
+ *
+ * Each rank records the key blocks it has finished as a sorted list of
+ * disjoint [lo, hi) intervals, merging neighbours as they are added, and
+ * periodically writes it to <prefix>.<rank>. A resumed search reads the
+ * files of all ranks of the previous run and skips their union.
+ *
+ * Files are written to a temporary name and renamed over the previous
+ * checkpoint, so a crash while writing leaves the old one intact. The first
+ * line holds a tag of the search target so a checkpoint cannot be resumed
+ * against a different ciphertext or match predicate.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+
+/** First word of a checkpoint file */
+#define CHECKPOINT_MAGIC "des-checkpoint"
+
+/**
+ * @brief Sorted list of disjoint, non-adjacent [lo, hi) key intervals
+ */
+typedef struct {
+    long (*iv)[2]; /**< Intervals in increasing order */
+    int n;         /**< Number of intervals */
+    int cap;       /**< Allocated intervals */
+} IntervalSet;
+
+/**
+ * @brief Index of the first interval ending at or after key
+ */
+static inline int intervalFind(const IntervalSet *set, long key){
+    int lo = 0, hi = set->n;
+    while(lo < hi){
+        int mid = (lo + hi) / 2;
+        if(set->iv[mid][1] < key){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Adds [lo, hi) to the set, merging it with the intervals it touches
+ *
+ * @return 1 on success, 0 on allocation failure
+ */
+static inline int intervalAdd(IntervalSet *set, long lo, long hi){
+    if(lo >= hi){
+        return 1;
+    }
+    int first = intervalFind(set, lo);
+    int last = first;
+    while(last < set->n && set->iv[last][0] <= hi){
+        last++;
+    }
+
+    if(first == last){
+        // No overlap: insert a new interval
+        if(set->n == set->cap){
+            int cap = set->cap ? 2 * set->cap : 64;
+            long (*iv)[2] = (long (*)[2])realloc(set->iv, sizeof(*iv) * cap);
+            if(!iv){
+                return 0;
+            }
+            set->iv = iv;
+            set->cap = cap;
+        }
+        memmove(set->iv + first + 1, set->iv + first, sizeof(*set->iv) * (set->n - first));
+        set->n++;
+    } else {
+        // Merge intervals first .. last-1 into one
+        if(set->iv[first][0] < lo) lo = set->iv[first][0];
+        if(set->iv[last - 1][1] > hi) hi = set->iv[last - 1][1];
+        memmove(set->iv + first + 1, set->iv + last, sizeof(*set->iv) * (set->n - last));
+        set->n -= last - first - 1;
+    }
+    set->iv[first][0] = lo;
+    set->iv[first][1] = hi;
+    return 1;
+}
+
+/**
+ * @brief Skips the interval containing key, if any
+ *
+ * @return The end of the interval containing key, or key itself
+ */
+static inline long intervalSkip(const IntervalSet *set, long key){
+    int i = intervalFind(set, key);
+    return (i < set->n && set->iv[i][0] <= key) ? set->iv[i][1] : key;
+}
+
+/**
+ * @brief Start of the first interval beginning after key, or LONG_MAX
+ */
+static inline long intervalNextStart(const IntervalSet *set, long key){
+    int i = intervalFind(set, key);
+    while(i < set->n && set->iv[i][0] <= key){
+        i++;
+    }
+    return (i < set->n) ? set->iv[i][0] : LONG_MAX;
+}
+
+/**
+ * @brief Total number of keys in the set
+ */
+static inline long intervalTotal(const IntervalSet *set){
+    long total = 0;
+    for(int i = 0; i < set->n; i++){
+        total += set->iv[i][1] - set->iv[i][0];
+    }
+    return total;
+}
+
+/**
+ * @brief Releases the intervals of a set
+ */
+static inline void intervalFree(IntervalSet *set){
+    free(set->iv);
+    set->iv = NULL;
+    set->n = set->cap = 0;
+}
+
+/**
+ * @brief Adds len bytes to an FNV-1a hash
+ */
+static inline uint64_t checkpointHash(uint64_t h, const void *data, size_t len){
+    const unsigned char *bytes = (const unsigned char *)data;
+    for(size_t i = 0; i < len; i++){
+        h = (h ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Tag identifying a search: FNV-1a over the ciphertext, the match predicate and the keyspace size
+ *
+ * Two searches share a tag only if they accept the same keys: same
+ * patterns (each hashed with its length, so their boundaries count), match
+ * mode, offset and known block.
+ *
+ * @param cipher Ciphertext
+ * @param ciphlen Length of the ciphertext
+ * @param patterns Search string followed by the additional patterns
+ * @param npatterns Number of patterns
+ * @param match_all Nonzero if every pattern must occur
+ * @param offset Byte offset of the search string, or -1
+ * @param known_block Byte offset of the known plaintext block, or -1
+ * @param upper Size of the keyspace
+ */
+static inline uint64_t checkpointTag(const unsigned char *cipher, int ciphlen, const char *const *patterns,
+                                     int npatterns, int match_all, int offset, int known_block, long upper){
+    uint64_t h = checkpointHash(0xcbf29ce484222325ULL, cipher, ciphlen);
+    for(int p = 0; p < npatterns; p++){
+        uint32_t len = (uint32_t)strlen(patterns[p]);
+        h = checkpointHash(h, &len, sizeof(len));
+        h = checkpointHash(h, patterns[p], len);
+    }
+    int32_t fields[4] = { npatterns, match_all != 0, offset, known_block };
+    h = checkpointHash(h, fields, sizeof(fields));
+    int64_t keyspace = upper;
+    return checkpointHash(h, &keyspace, sizeof(keyspace));
+}
+
+/**
+ * @brief Writes the searched intervals of a rank to <prefix>.<rank>
+ *
+ * @param prefix Checkpoint file prefix
+ * @param rank MPI rank writing the file
+ * @param tag Search tag (see checkpointTag)
+ * @param set Searched intervals
+ * @return 1 on success, 0 if the file cannot be written
+ */
+static inline int checkpointWrite(const char *prefix, int rank, uint64_t tag, const IntervalSet *set){
+    char path[4096], tmp[4096 + 8];
+    snprintf(path, sizeof(path), "%s.%d", prefix, rank);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *file = fopen(tmp, "w");
+    if(!file){
+        return 0;
+    }
+    fprintf(file, "%s %016llx\n", CHECKPOINT_MAGIC, (unsigned long long)tag);
+    for(int i = 0; i < set->n; i++){
+        fprintf(file, "%ld %ld\n", set->iv[i][0], set->iv[i][1]);
+    }
+    if(fclose(file) != 0){
+        return 0;
+    }
+    return rename(tmp, path) == 0;
+}
+
+/**
+ * @brief Reads the checkpoints <prefix>.0, <prefix>.1, ... into one set
+ *
+ * Stops at the first missing rank, so any number of ranks of the previous
+ * run is picked up.
+ *
+ * @param prefix Checkpoint file prefix
+ * @param tag Search tag the files must carry
+ * @param set Set to add the searched intervals to
+ * @return Number of files read, or -1 on a malformed or mismatching file
+ */
+static inline int checkpointRead(const char *prefix, uint64_t tag, IntervalSet *set){
+    int files = 0;
+    for(;; files++){
+        char path[4096], magic[32];
+        unsigned long long file_tag;
+        long lo, hi;
+        snprintf(path, sizeof(path), "%s.%d", prefix, files);
+
+        FILE *file = fopen(path, "r");
+        if(!file){
+            return files;
+        }
+        if(fscanf(file, "%31s %llx", magic, &file_tag) != 2 || strcmp(magic, CHECKPOINT_MAGIC) != 0 ||
+           file_tag != tag){
+            printf("Error: %s is not a checkpoint of this search\n", path);
+            fclose(file);
+            return -1;
+        }
+        while(fscanf(file, "%ld %ld", &lo, &hi) == 2){
+            if(!intervalAdd(set, lo, hi)){
+                fclose(file);
+                return -1;
+            }
+        }
+        fclose(file);
+    }
+}
+
+#endif /* CHECKPOINT_H */
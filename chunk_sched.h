@@ -0,0 +1,279 @@
+/**
+ * @file chunk_sched.h
+ * @brief Keyspace scheduler: static per-rank ranges or chunks handed out by rank 0
+ *
+ * In static mode every rank searches a fixed slice of the keyspace, so the
+ * whole search takes as long as its slowest rank. In dynamic mode rank 0
+ * acts as coordinator: it keeps the next unassigned key and answers chunk
+ * requests from the other ranks between its own chunks, so faster ranks
+ * simply take more chunks.
+ *
+ * Workers ask for their next chunk as soon as they receive one, so the
+ * reply is already waiting when the current chunk is done and the
+ * coordinator's polling interval is hidden. While a rank waits for a
+ * message it keeps polling the stop signal (see termination.h), so the end
+ * of the search is never missed.
+ *
+ * After a stop, rank 0 no longer serves requests, so a worker's last one
+ * may still be in flight. schedFinish counts the requests sent and
+ * received across ranks and answers the missing ones, so no message is
+ * left unmatched at MPI_Finalize.
+ *
+ * Keys already searched by a previous run (see checkpoint.h) are skipped:
+ * ranges are cut at their boundaries, so no chunk contains a searched key.
+ *
+ * Only one thread per rank may call these functions.
+ */
+
+#ifndef CHUNK_SCHED_H
+#define CHUNK_SCHED_H
+
+#include <mpi.h>
+#include "checkpoint.h"
+#include "termination.h"
+
+/** Chunk request, worker -> rank 0 */
+#define SCHED_TAG_REQUEST 1
+/** Chunk assignment [lo, hi), rank 0 -> worker; lo == hi once the keyspace is exhausted */
+#define SCHED_TAG_CHUNK 2
+/** Seconds between stop signal polls while waiting for a message */
+#define SCHED_STOP_POLL 1e-3
+
+/**
+ * @brief Scheduler state of one rank
+ */
+typedef struct {
+    MPI_Comm comm;
+    int rank;
+    int size;
+    int dynamic;               /**< Nonzero for chunks from rank 0, zero for a static range */
+    long next;                 /**< First key not handed out yet (rank 0, or own range if static) */
+    long upper;                /**< End of the keys to hand out */
+    long chunk;                /**< Keys per chunk */
+    const IntervalSet *skip;   /**< Keys not to hand out again, or NULL */
+    int retired;               /**< Rank 0: workers already told the keyspace is exhausted */
+    int request;               /**< Buffer of chunk request messages */
+    long requests;             /**< Chunk requests sent (worker) or received (rank 0) */
+    MPI_Request request_req;   /**< Rank 0: posted receive for chunk requests */
+    MPI_Request send_req;      /**< Worker: chunk request in flight */
+    long reply[2];             /**< Worker: buffer of the requested chunk */
+    MPI_Request reply_req;     /**< Worker: posted receive for the requested chunk */
+} ChunkScheduler;
+
+/**
+ * @brief Sets up the scheduler
+ *
+ * @param s Scheduler to initialize
+ * @param comm Communicator of the search
+ * @param lower First key of this rank's range (static mode)
+ * @param upper End of this rank's range (static mode) or of the keyspace (dynamic mode)
+ * @param chunk Keys per chunk in dynamic mode, 0 for static mode
+ * @param skip Keys already searched (must outlive the scheduler), or NULL
+ */
+static void schedInit(ChunkScheduler *s, MPI_Comm comm, long lower, long upper, long chunk,
+                      const IntervalSet *skip){
+    MPI_Comm_rank(comm, &s->rank);
+    MPI_Comm_size(comm, &s->size);
+    s->comm = comm;
+    s->dynamic = (chunk > 0);
+    s->next = s->dynamic ? 0 : lower;
+    s->upper = upper;
+    s->chunk = s->dynamic ? chunk : upper - lower;
+    s->skip = skip;
+    s->retired = 0;
+    s->request = 0;
+    s->requests = 0;
+    s->request_req = MPI_REQUEST_NULL;
+    s->send_req = MPI_REQUEST_NULL;
+    s->reply_req = MPI_REQUEST_NULL;
+
+    if(s->dynamic && s->rank == 0 && s->size > 1){
+        MPI_Irecv(&s->request, 1, MPI_INT, MPI_ANY_SOURCE, SCHED_TAG_REQUEST, comm, &s->request_req);
+    }
+}
+
+/**
+ * @brief Takes the next chunk of the keys left, or an empty one if none are left
+ */
+static void schedTake(ChunkScheduler *s, long range[2]){
+    long lo = s->next, hi;
+    if(s->skip){
+        lo = intervalSkip(s->skip, lo);
+    }
+    if(lo >= s->upper){
+        range[0] = range[1] = s->next = s->upper;
+        return;
+    }
+    hi = (s->upper - lo > s->chunk) ? lo + s->chunk : s->upper;
+    if(s->skip && intervalNextStart(s->skip, lo) < hi){
+        hi = intervalNextStart(s->skip, lo);
+    }
+    range[0] = lo;
+    range[1] = hi;
+    s->next = hi;
+}
+
+/**
+ * @brief Rank 0: sends a chunk to the worker whose request was just received
+ *
+ * Keeps receiving requests until every worker has been sent an empty chunk.
+ */
+static void schedAnswer(ChunkScheduler *s, int worker){
+    long range[2];
+    s->requests++;
+    schedTake(s, range);
+    if(range[0] == range[1]){
+        s->retired++;
+    }
+    MPI_Send(range, 2, MPI_LONG, worker, SCHED_TAG_CHUNK, s->comm);
+
+    if(s->retired < s->size - 1){
+        MPI_Irecv(&s->request, 1, MPI_INT, MPI_ANY_SOURCE, SCHED_TAG_REQUEST, s->comm, &s->request_req);
+    }
+}
+
+/**
+ * @brief Rank 0: answers the chunk requests that have arrived, without blocking
+ *
+ * Called from rank 0's polling points while it searches its own chunks.
+ */
+static void schedServe(ChunkScheduler *s){
+    int got = 1;
+    MPI_Status st;
+    while(s->request_req != MPI_REQUEST_NULL){
+        MPI_Test(&s->request_req, &got, &st);
+        if(!got){
+            break;
+        }
+        schedAnswer(s, st.MPI_SOURCE);
+    }
+}
+
+/**
+ * @brief Worker: asks rank 0 for a chunk without waiting for the answer
+ *
+ * The previous request was answered already, so waiting for its send
+ * returns at once.
+ */
+static void schedRequest(ChunkScheduler *s){
+    MPI_Wait(&s->send_req, MPI_STATUS_IGNORE);
+    MPI_Irecv(s->reply, 2, MPI_LONG, 0, SCHED_TAG_CHUNK, s->comm, &s->reply_req);
+    MPI_Isend(&s->request, 1, MPI_INT, 0, SCHED_TAG_REQUEST, s->comm, &s->send_req);
+    s->requests++;
+}
+
+/**
+ * @brief Waits for a request, polling the stop signal meanwhile
+ *
+ * @return 1 once the request completed, 0 if the search was stopped first
+ */
+static int schedWait(MPI_Request *req, MPI_Status *st, Termination *term){
+    double next_poll = 0;
+    for(;;){
+        int done;
+        MPI_Test(req, &done, st);
+        if(done){
+            return 1;
+        }
+        double now = MPI_Wtime();
+        if(now >= next_poll){
+            if(termPoll(term) != 0){
+                return 0;
+            }
+            next_poll = now + SCHED_STOP_POLL;
+        }
+    }
+}
+
+/**
+ * @brief Gets the next range of keys to search
+ *
+ * Blocks until a chunk arrives or the search is stopped, so a rank waiting
+ * on the coordinator still notices the end of the search.
+ *
+ * @param s Scheduler
+ * @param lo Pointer to store the first key of the range
+ * @param hi Pointer to store the end of the range (exclusive)
+ * @param term Stop signal of the search
+ * @return 1 if a non-empty range was assigned, 0 when the search is over
+ */
+static int schedNext(ChunkScheduler *s, long *lo, long *hi, Termination *term){
+    long range[2];
+    MPI_Status st;
+
+    if(!s->dynamic || s->rank == 0){
+        schedServe(s);
+        schedTake(s, range);
+        if(range[0] < range[1]){
+            *lo = range[0];
+            *hi = range[1];
+            return 1;
+        }
+
+        // Keyspace exhausted: the other ranks still need their empty chunk
+        while(s->request_req != MPI_REQUEST_NULL){
+            if(!schedWait(&s->request_req, &st, term)){
+                return 0;
+            }
+            schedAnswer(s, st.MPI_SOURCE);
+        }
+        return 0;
+    }
+
+    if(s->reply_req == MPI_REQUEST_NULL){
+        schedRequest(s);
+    }
+    if(!schedWait(&s->reply_req, &st, term)){
+        return 0;
+    }
+    if(s->reply[0] == s->reply[1]){
+        return 0;
+    }
+
+    *lo = s->reply[0];
+    *hi = s->reply[1];
+    // Prefetch: the next chunk travels while this one is searched
+    schedRequest(s);
+    return 1;
+}
+
+/**
+ * @brief Completes the chunk messages still in flight at the end of the search (collective)
+ *
+ * Rank 0 answers every request it has not received yet with an empty
+ * chunk, and workers wait for those answers. Must be called once every
+ * rank has stopped searching (after termFinish), so no new request can
+ * be sent meanwhile.
+ */
+static void schedFinish(ChunkScheduler *s){
+    MPI_Status st;
+    if(!s->dynamic){
+        return;
+    }
+    long sent = (s->rank == 0) ? 0 : s->requests;
+    long total = 0;
+    MPI_Reduce(&sent, &total, 1, MPI_LONG, MPI_SUM, 0, s->comm);
+
+    if(s->rank == 0){
+        long empty[2] = { s->upper, s->upper };
+        if(s->request_req != MPI_REQUEST_NULL){
+            int cancelled;
+            MPI_Cancel(&s->request_req);
+            MPI_Wait(&s->request_req, &st);
+            MPI_Test_cancelled(&st, &cancelled);
+            if(!cancelled){
+                s->requests++;
+                MPI_Send(empty, 2, MPI_LONG, st.MPI_SOURCE, SCHED_TAG_CHUNK, s->comm);
+            }
+        }
+        for(; s->requests < total; s->requests++){
+            MPI_Recv(&s->request, 1, MPI_INT, MPI_ANY_SOURCE, SCHED_TAG_REQUEST, s->comm, &st);
+            MPI_Send(empty, 2, MPI_LONG, st.MPI_SOURCE, SCHED_TAG_CHUNK, s->comm);
+        }
+    } else {
+        MPI_Wait(&s->send_req, &st);
+        MPI_Wait(&s->reply_req, &st);
+    }
+}
+
+#endif /* CHUNK_SCHED_H */
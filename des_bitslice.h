@@ -0,0 +1,422 @@
+/**
+ * @file des_bitslice.h
+ * @brief Bitsliced DES key search engine
+ *
+ * Instead of running DES on one key at a time, the bitsliced engine stores
+ * bit i of the DES state of many candidate keys in the same machine word
+ * (one key per bit "lane") and evaluates the S-boxes as boolean gate
+ * circuits. A 64-bit word therefore tests 64 keys per pass, and the key
+ * schedule costs nothing: every subkey bit is just one of the key bit words.
+ *
+ * On x86-64 the same kernel is also built for 256-bit AVX2 and 512-bit
+ * AVX-512 words (the latter using vpternlogq for the S-box multiplexers),
+ * and bsSelectKernel picks the widest one the CPU supports at startup.
+ */
+
+#ifndef DES_BITSLICE_H
+#define DES_BITSLICE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "des_tables.h"
+#include "des_sboxes.h"
+#include "matcher.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define BS_HAVE_X86_KERNELS 1
+#endif
+
+/** Largest number of keys tested by one bsSearch call */
+#define BS_MAX_LANES 512
+
+/**
+ * @brief Read-only search state shared by all threads
+ */
+typedef struct {
+    const unsigned char *cipher; /**< Ciphertext buffer */
+    int ciphlen;                 /**< Ciphertext length in bytes */
+    const char *search;          /**< Search string */
+    int search_len;              /**< Length of the search string */
+    const Matcher *matcher;      /**< Matcher for the search string */
+    int offset;                  /**< Known byte offset of the search string, or -1 */
+    int partial;                 /**< Decrypt only the blocks that can decide a match */
+    int nblocks;                 /**< Number of complete 8-byte blocks */
+    uint64_t *ip_blocks;         /**< Ciphertext blocks after IP, bit i = DES bit i+1 */
+    int known_block;             /**< Block index with known plaintext, or -1 */
+    uint64_t known_ip;           /**< Known plaintext block after IP */
+} BitsliceCtx;
+
+/**
+ * @brief Per-thread scratch buffers
+ */
+typedef struct {
+    unsigned char *plain; /**< BS_MAX_LANES plaintext buffers of ciphlen+1 bytes */
+} BitsliceWork;
+
+/** Search key bit feeding each subkey bit, per round */
+static unsigned char bs_key_map[16][48];
+/** Position after the P permutation of each S-box output bit */
+static unsigned char bs_p_inv[32];
+/** Pre-output bit that ends up at each bit of a little-endian plaintext word */
+static unsigned char bs_fp_row[64];
+/** Lane patterns of the 6 lowest key bits within a 64-lane group */
+static const uint64_t bs_lane_pattern[6] = {
+    0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+/**
+ * @brief Returns bit n (1-based DES numbering) of an 8-byte block
+ */
+static inline int bsBlockBit(const unsigned char *block, int n){
+    return (block[(n - 1) / 8] >> (7 - (n - 1) % 8)) & 1;
+}
+
+/**
+ * @brief Precomputes the key schedule and permutation tables
+ *
+ * Must be called once before any other bitslice function.
+ */
+static void bsInitTables(void){
+    // Key schedule: rotate the PC1 halves and pick the PC2 bits of each round
+    int shift = 0;
+    for(int round = 0; round < 16; round++){
+        shift += des_shifts[round];
+        for(int j = 0; j < 48; j++){
+            int pos = des_pc2[j] - 1;
+            int half = (pos < 28) ? 0 : 28;
+            int rotated = half + (pos - half + shift) % 28;
+            bs_key_map[round][j] = desKeyBitToSearchBit(des_pc1[rotated]);
+        }
+    }
+
+    for(int i = 0; i < 32; i++){
+        bs_p_inv[des_p[i] - 1] = i;
+    }
+
+    // Plaintext DES bit des_ip[i] is pre-output bit i; place it at its
+    // position in a little-endian 64-bit word of the plaintext bytes
+    for(int i = 0; i < 64; i++){
+        int n = des_ip[i] - 1;
+        int row = 8 * (n / 8) + 7 - n % 8;
+        bs_fp_row[row] = i;
+    }
+}
+
+/**
+ * @brief Prepares the shared search context for a ciphertext
+ *
+ * @param ctx Context to initialize
+ * @param cipher Ciphertext buffer
+ * @param ciphlen Ciphertext length in bytes
+ * @param search Search string to look for in decrypted text
+ * @param matcher Matcher for the search string
+ * @return 1 on success, 0 on allocation failure
+ */
+static int bsInitContext(BitsliceCtx *ctx, const unsigned char *cipher, int ciphlen, const char *search,
+                         const Matcher *matcher){
+    ctx->cipher = cipher;
+    ctx->ciphlen = ciphlen;
+    ctx->search = search;
+    ctx->search_len = strlen(search);
+    ctx->matcher = matcher;
+    ctx->offset = -1;
+    ctx->partial = 0;
+    ctx->known_block = -1;
+    ctx->nblocks = ciphlen / 8;
+    ctx->ip_blocks = (uint64_t *)malloc(sizeof(uint64_t) * (ctx->nblocks + 1));
+    if(!ctx->ip_blocks){
+        return 0;
+    }
+
+    // The initial permutation of the ciphertext is the same for every key
+    for(int b = 0; b < ctx->nblocks; b++){
+        uint64_t ip = 0;
+        for(int i = 0; i < 64; i++){
+            ip |= (uint64_t)bsBlockBit(cipher + 8 * b, des_ip[i]) << i;
+        }
+        ctx->ip_blocks[b] = ip;
+    }
+    return 1;
+}
+
+/**
+ * @brief Switches a context to known-plaintext block comparison
+ *
+ * Candidate keys are then tested by encrypting the known plaintext and
+ * comparing against the ciphertext block; only matching lanes go on to
+ * the full decryption and string search.
+ *
+ * @param ctx Search context
+ * @param block Index of the ciphertext block whose plaintext is known
+ * @param plain The 8 known plaintext bytes
+ */
+static void bsSetKnownBlock(BitsliceCtx *ctx, int block, const unsigned char *plain){
+    uint64_t ip = 0;
+    for(int i = 0; i < 64; i++){
+        ip |= (uint64_t)bsBlockBit(plain, des_ip[i]) << i;
+    }
+    ctx->known_block = block;
+    ctx->known_ip = ip;
+}
+
+/**
+ * @brief Releases the buffers owned by a search context
+ */
+static void bsFreeContext(BitsliceCtx *ctx){
+    free(ctx->ip_blocks);
+    ctx->ip_blocks = NULL;
+}
+
+/**
+ * @brief Allocates the per-thread scratch buffers for a context
+ *
+ * @return 1 on success, 0 on allocation failure
+ */
+static int bsInitWork(BitsliceWork *work, const BitsliceCtx *ctx){
+    work->plain = (unsigned char *)calloc(BS_MAX_LANES, ctx->ciphlen + 1);
+    return work->plain != NULL;
+}
+
+/**
+ * @brief Releases per-thread scratch buffers
+ */
+static void bsFreeWork(BitsliceWork *work){
+    free(work->plain);
+    work->plain = NULL;
+}
+
+/**
+ * @brief Transposes a 64x64 bit matrix in place
+ *
+ * On entry bit c of a[r] is element (r, c); on return it is element (c, r).
+ */
+static void bsTranspose64(uint64_t a[64]){
+    uint64_t m = 0x00000000FFFFFFFFULL;
+
+    for(int j = 32; j != 0; j >>= 1, m ^= m << j){
+        for(int k = 0; k < 64; k = ((k | j) + 1) & ~j){
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+/**
+ * @brief Returns the index of the lowest set lane in a match bitmask
+ *
+ * @param match Match bitmask as filled by a bsSearch kernel
+ * @param words Number of 64-bit words in the bitmask
+ * @return Lane index, or -1 if no lane is set
+ */
+static int bsFirstLane(const uint64_t *match, int words){
+    for(int w = 0; w < words; w++){
+        if(match[w]){
+            return 64 * w + __builtin_ctzll(match[w]);
+        }
+    }
+    return -1;
+}
+
+/* 64 lanes in a plain 64-bit integer */
+#define BS_T uint64_t
+#define BS_WORDS 1
+#define BS_FN(name) name##64
+#define BS_TARGET
+#define BS_ZERO ((uint64_t)0)
+#define BS_ONES (~(uint64_t)0)
+#define BS_AND(a, b) ((a) & (b))
+#define BS_OR(a, b) ((a) | (b))
+#define BS_XOR(a, b) ((a) ^ (b))
+#define BS_ANDN(a, b) ((a) & ~(b))
+#define BS_NOT(a) (~(a))
+#define BS_SEL(s, a, b) ((a) ^ (((a) ^ (b)) & (s)))
+#define BS_ISZERO(a) ((a) == 0)
+#include "des_bs_kernel.h"
+#undef BS_T
+#undef BS_WORDS
+#undef BS_FN
+#undef BS_TARGET
+#undef BS_ZERO
+#undef BS_ONES
+#undef BS_AND
+#undef BS_OR
+#undef BS_XOR
+#undef BS_ANDN
+#undef BS_NOT
+#undef BS_SEL
+#undef BS_ISZERO
+
+#ifdef BS_HAVE_X86_KERNELS
+/* 256 lanes in an AVX2 register */
+#define BS_T __m256i
+#define BS_WORDS 4
+#define BS_FN(name) name##256
+#define BS_TARGET __attribute__((target("avx2")))
+#define BS_ZERO _mm256_setzero_si256()
+#define BS_ONES _mm256_set1_epi64x(-1)
+#define BS_AND(a, b) _mm256_and_si256((a), (b))
+#define BS_OR(a, b) _mm256_or_si256((a), (b))
+#define BS_XOR(a, b) _mm256_xor_si256((a), (b))
+#define BS_ANDN(a, b) _mm256_andnot_si256((b), (a))
+#define BS_NOT(a) _mm256_xor_si256((a), BS_ONES)
+#define BS_SEL(s, a, b) BS_XOR((a), BS_AND(BS_XOR((a), (b)), (s)))
+#define BS_ISZERO(a) _mm256_testz_si256((a), (a))
+#include "des_bs_kernel.h"
+#undef BS_T
+#undef BS_WORDS
+#undef BS_FN
+#undef BS_TARGET
+#undef BS_ZERO
+#undef BS_ONES
+#undef BS_AND
+#undef BS_OR
+#undef BS_XOR
+#undef BS_ANDN
+#undef BS_NOT
+#undef BS_SEL
+#undef BS_ISZERO
+
+/* 512 lanes in an AVX-512 register; multiplexers are a single vpternlogq */
+#define BS_T __m512i
+#define BS_WORDS 8
+#define BS_FN(name) name##512
+#define BS_TARGET __attribute__((target("avx512f")))
+#define BS_ZERO _mm512_setzero_si512()
+#define BS_ONES _mm512_set1_epi64(-1)
+#define BS_AND(a, b) _mm512_and_si512((a), (b))
+#define BS_OR(a, b) _mm512_or_si512((a), (b))
+#define BS_XOR(a, b) _mm512_xor_si512((a), (b))
+#define BS_ANDN(a, b) _mm512_andnot_si512((b), (a))
+#define BS_NOT(a) _mm512_ternarylogic_epi64((a), (a), (a), 0x55)
+#define BS_SEL(s, a, b) _mm512_ternarylogic_epi64((s), (b), (a), 0xCA)
+#define BS_ISZERO(a) (_mm512_test_epi64_mask((a), (a)) == 0)
+#include "des_bs_kernel.h"
+#undef BS_T
+#undef BS_WORDS
+#undef BS_FN
+#undef BS_TARGET
+#undef BS_ZERO
+#undef BS_ONES
+#undef BS_AND
+#undef BS_OR
+#undef BS_XOR
+#undef BS_ANDN
+#undef BS_NOT
+#undef BS_SEL
+#undef BS_ISZERO
+#endif /* BS_HAVE_X86_KERNELS */
+
+/** Signature shared by the bsSearch kernels of every word width */
+typedef int (*BitsliceSearchFn)(const BitsliceCtx *ctx, BitsliceWork *work,
+                                long base, long lo, long hi, uint64_t *match);
+
+/**
+ * @brief A bitsliced kernel instantiation
+ */
+typedef struct {
+    const char *name;        /**< Kernel name as accepted by --kernel */
+    int lanes;               /**< Keys tested per call (power of two) */
+    BitsliceSearchFn search; /**< Batch search function */
+} BitsliceKernel;
+
+/** Kernel identifiers, from narrowest to widest */
+enum { BS_KERNEL_SCALAR, BS_KERNEL_AVX2, BS_KERNEL_AVX512, BS_KERNEL_COUNT };
+
+/** All kernels compiled into this binary, indexed by BS_KERNEL_* */
+static const BitsliceKernel bs_kernels[BS_KERNEL_COUNT] = {
+    { "scalar", 64, bsSearch64 },
+#ifdef BS_HAVE_X86_KERNELS
+    { "avx2", 256, bsSearch256 },
+    { "avx512", 512, bsSearch512 },
+#else
+    { "avx2", 0, NULL },
+    { "avx512", 0, NULL },
+#endif
+};
+
+/**
+ * @brief Returns the widest kernel the running CPU and OS support
+ *
+ * Queries cpuid for AVX2/AVX-512F and XGETBV for the register state the
+ * OS saves on context switches.
+ *
+ * @return BS_KERNEL_* identifier
+ */
+static int bsDetectKernel(void){
+#ifdef BS_HAVE_X86_KERNELS
+    unsigned int eax, ebx, ecx, edx;
+
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)){
+        return BS_KERNEL_SCALAR;
+    }
+    // OSXSAVE and AVX are both required before XGETBV/YMM use is legal
+    if(!(ecx & (1u << 27)) || !(ecx & (1u << 28))){
+        return BS_KERNEL_SCALAR;
+    }
+
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if((xcr0_lo & 0x06) != 0x06){ // XMM and YMM state
+        return BS_KERNEL_SCALAR;
+    }
+
+    if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)){
+        return BS_KERNEL_SCALAR;
+    }
+    if((ebx & (1u << 16)) && (xcr0_lo & 0xE0) == 0xE0){ // AVX-512F, opmask/ZMM state
+        return BS_KERNEL_AVX512;
+    }
+    if(ebx & (1u << 5)){
+        return BS_KERNEL_AVX2;
+    }
+#endif
+    return BS_KERNEL_SCALAR;
+}
+
+/**
+ * @brief Tells whether a --kernel name is "auto" or one of the kernels, supported or not
+ */
+static int bsKernelKnown(const char *name){
+    if(strcmp(name, "auto") == 0){
+        return 1;
+    }
+    for(int k = 0; k < BS_KERNEL_COUNT; k++){
+        if(strcmp(name, bs_kernels[k].name) == 0){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Chooses the kernel used by the bitsliced engine
+ *
+ * @param name Kernel requested by the user ("auto" picks the widest supported)
+ * @param kernel Pointer to store the selected kernel
+ * @return 1 on success, 0 if the name is unknown or the CPU lacks support
+ */
+static int bsSelectKernel(const char *name, BitsliceKernel *kernel){
+    int best = bsDetectKernel();
+
+    if(strcmp(name, "auto") == 0){
+        *kernel = bs_kernels[best];
+        return 1;
+    }
+    for(int k = 0; k < BS_KERNEL_COUNT; k++){
+        if(strcmp(name, bs_kernels[k].name) == 0){
+            if(k > best){
+                return 0;
+            }
+            *kernel = bs_kernels[k];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif /* DES_BITSLICE_H */
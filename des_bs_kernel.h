@@ -0,0 +1,347 @@
+/**
+ * @file des_bs_kernel.h
+ * @brief Bitsliced DES kernel template
+ *
+ * This file is included once per word type by des_bitslice.h and has no
+ * include guard on purpose. Before including it, define:
+ *   BS_T           word type holding one bit of every lane
+ *   BS_WORDS       number of 64-bit lane groups in a BS_T
+ *   BS_FN(name)    suffixes function names for this instantiation
+ *   BS_TARGET      function attributes for this instantiation (may be empty)
+ *   BS_ZERO/BS_ONES and the gate macros required by des_sboxes.h
+ *   BS_ISZERO(a)   nonzero if no lane of a is set
+ *
+ * Lane l of a batch tests key (base + l), where base is aligned to the
+ * batch width, so the low key bits follow fixed patterns across lanes and
+ * the high bits are the same in every lane.
+ */
+
+/**
+ * @brief Builds the bitsliced key words for a batch of consecutive keys
+ *
+ * @param base First key of the batch (aligned to the batch width)
+ * @param K Output: K[b] holds bit b of the 56-bit search key of every lane
+ */
+static BS_TARGET void BS_FN(bsKeyWords)(long base, BS_T K[56]){
+    uint64_t w[BS_WORDS];
+
+    for(int b = 0; b < 56; b++){
+        for(int i = 0; i < BS_WORDS; i++){
+            long key0 = base + 64L * i; // key of lane 0 in this group
+            if(b < 6){
+                w[i] = bs_lane_pattern[b];
+            } else {
+                w[i] = ((key0 >> b) & 1) ? ~(uint64_t)0 : 0;
+            }
+        }
+        memcpy(&K[b], w, sizeof(BS_T));
+    }
+}
+
+/** Index into R of E-expansion bit t (0..5) feeding S-box n (1..8) */
+#define BS_E(n, t) (((n) * 4 - 5 + (t)) & 31)
+
+/** Evaluates S-box n of one round and XORs its permuted output into l */
+#define BS_ROUND_SBOX(n) DES_SBOX##n( \
+    BS_XOR(r[BS_E(n, 0)], K[km[6 * ((n) - 1) + 0]]), \
+    BS_XOR(r[BS_E(n, 1)], K[km[6 * ((n) - 1) + 1]]), \
+    BS_XOR(r[BS_E(n, 2)], K[km[6 * ((n) - 1) + 2]]), \
+    BS_XOR(r[BS_E(n, 3)], K[km[6 * ((n) - 1) + 3]]), \
+    BS_XOR(r[BS_E(n, 4)], K[km[6 * ((n) - 1) + 4]]), \
+    BS_XOR(r[BS_E(n, 5)], K[km[6 * ((n) - 1) + 5]]), \
+    l[bs_p_inv[4 * ((n) - 1) + 0]], \
+    l[bs_p_inv[4 * ((n) - 1) + 1]], \
+    l[bs_p_inv[4 * ((n) - 1) + 2]], \
+    l[bs_p_inv[4 * ((n) - 1) + 3]])
+
+/**
+ * @brief Runs the first DES rounds on a bitsliced block
+ *
+ * On entry L and R hold the two halves of the block after the initial
+ * permutation. On return they hold L and R after the given (even) number
+ * of rounds; after all 16, R holds R16 and L holds L16, i.e. the
+ * pre-output block (R16 || L16) that the final permutation is applied to.
+ *
+ * @param K Bitsliced search key words (see bsKeyWords)
+ * @param L Left half, bit i = DES bit i+1
+ * @param R Right half, bit i = DES bit i+33
+ * @param rounds Number of rounds to run (even, at most 16)
+ * @param decrypt Nonzero to apply the subkeys in reverse order
+ */
+static BS_TARGET void BS_FN(bsDesRounds)(const BS_T K[56], BS_T L[32], BS_T R[32], int rounds, int decrypt){
+    BS_T *l = L, *r = R, *t;
+
+    for(int round = 0; round < rounds; round++){
+        const unsigned char *km = bs_key_map[decrypt ? 15 - round : round];
+
+        BS_ROUND_SBOX(1);
+        BS_ROUND_SBOX(2);
+        BS_ROUND_SBOX(3);
+        BS_ROUND_SBOX(4);
+        BS_ROUND_SBOX(5);
+        BS_ROUND_SBOX(6);
+        BS_ROUND_SBOX(7);
+        BS_ROUND_SBOX(8);
+
+        t = l;
+        l = r;
+        r = t;
+    }
+}
+
+/**
+ * @brief Decrypts one ciphertext block under every lane of a batch
+ *
+ * Writes the 8 plaintext bytes of each lane to its buffer in work->plain.
+ *
+ * @param ctx Search context
+ * @param work Per-thread scratch buffers
+ * @param K Bitsliced key words of the batch
+ * @param b Block index
+ */
+static BS_TARGET void BS_FN(bsDecryptBlock)(const BitsliceCtx *ctx, BitsliceWork *work,
+                                             const BS_T K[56], int b){
+    BS_T L[32], R[32];
+    uint64_t rows[64];
+    int stride = ctx->ciphlen + 1;
+    uint64_t ip = ctx->ip_blocks[b];
+
+    for(int i = 0; i < 32; i++){
+        L[i] = ((ip >> i) & 1) ? BS_ONES : BS_ZERO;
+        R[i] = ((ip >> (32 + i)) & 1) ? BS_ONES : BS_ZERO;
+    }
+
+    BS_FN(bsDesRounds)(K, L, R, 16, 1);
+
+    // Undo the bitslicing one 64-lane group at a time
+    for(int w = 0; w < BS_WORDS; w++){
+        for(int p = 0; p < 64; p++){
+            int j = bs_fp_row[p];
+            const BS_T *v = (j < 32) ? &R[j] : &L[j - 32];
+            memcpy(&rows[p], (const char *)v + 8 * w, 8);
+        }
+        bsTranspose64(rows);
+        for(int lane = 0; lane < 64; lane++){
+            memcpy(work->plain + (64 * w + lane) * stride + 8 * b, &rows[lane], 8);
+        }
+    }
+}
+
+/**
+ * @brief Searches the fully decrypted text of the selected lanes
+ *
+ * @param ctx Search context
+ * @param work Per-thread scratch buffers holding every decrypted block
+ * @param lanes Input: lanes to check; output: lanes that matched
+ * @return Number of matching lanes
+ */
+static int BS_FN(bsMatchLanes)(const BitsliceCtx *ctx, BitsliceWork *work, uint64_t *lanes){
+    int stride = ctx->ciphlen + 1;
+    int matches = 0;
+
+    for(int w = 0; w < BS_WORDS; w++){
+        uint64_t todo = lanes[w];
+        lanes[w] = 0;
+        while(todo){
+            int lane = __builtin_ctzll(todo);
+            todo &= todo - 1;
+            const unsigned char *text = work->plain + (64 * w + lane) * stride;
+            if(matcherContains(ctx->matcher, text, ctx->ciphlen)){
+                lanes[w] |= (uint64_t)1 << lane;
+                matches++;
+            }
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Narrows the candidate lanes using only the blocks holding the search string
+ *
+ * Used when the byte offset of the search string is known: the covering
+ * blocks are decrypted one at a time and a lane is dropped on its first
+ * mismatching byte. Most batches are rejected after a single block.
+ *
+ * @param ctx Search context
+ * @param work Per-thread scratch buffers
+ * @param K Bitsliced key words of the batch
+ * @param alive Input: candidate lanes; output: lanes matching at the offset
+ * @param done Output: nonzero for each block index that was decrypted
+ * @return Number of surviving lanes
+ */
+static BS_TARGET int BS_FN(bsFilterAtOffset)(const BitsliceCtx *ctx, BitsliceWork *work,
+                                              const BS_T K[56], uint64_t *alive, unsigned char *done){
+    int stride = ctx->ciphlen + 1;
+    int end = ctx->offset + ctx->search_len;
+    int survivors = 0;
+
+    for(int b = ctx->offset / 8; 8 * b < end; b++){
+        BS_FN(bsDecryptBlock)(ctx, work, K, b);
+        done[b] = 1;
+
+        int from = (8 * b > ctx->offset) ? 8 * b : ctx->offset;
+        int to = (8 * b + 8 < end) ? 8 * b + 8 : end;
+        const char *expect = ctx->search + (from - ctx->offset);
+
+        survivors = 0;
+        for(int w = 0; w < BS_WORDS; w++){
+            uint64_t todo = alive[w];
+            while(todo){
+                int lane = __builtin_ctzll(todo);
+                todo &= todo - 1;
+                if(memcmp(work->plain + (64 * w + lane) * stride + from, expect, to - from) != 0){
+                    alive[w] &= ~((uint64_t)1 << lane);
+                }
+            }
+            survivors += __builtin_popcountll(alive[w]);
+        }
+        if(survivors == 0){
+            break;
+        }
+    }
+    return survivors;
+}
+
+/**
+ * Compares the 4 output bits of S-box n, just XORed into l, with the
+ * expected pre-output bits starting at bit ofs, and rejects the batch
+ * once no lane is left.
+ */
+#define BS_CHECK_SBOX(n, ofs) do { \
+    for(int k = 0; k < 4; k++){ \
+        int p = bs_p_inv[4 * ((n) - 1) + k]; \
+        ok = ((expect >> ((ofs) + p)) & 1) ? BS_AND(ok, l[p]) : BS_ANDN(ok, l[p]); \
+    } \
+    if(BS_ISZERO(ok)){ \
+        memset(alive, 0, sizeof(BS_T)); \
+        return 0; \
+    } \
+} while(0)
+
+/** Evaluates one S-box of the current round and checks its output bits */
+#define BS_ROUND_SBOX_CHECK(n, ofs) do { \
+    BS_ROUND_SBOX(n); \
+    BS_CHECK_SBOX(n, ofs); \
+} while(0)
+
+/**
+ * @brief Narrows the candidate lanes by encrypting the known plaintext block
+ *
+ * The pre-output block (R16 || L16) of a matching key equals IP of the
+ * ciphertext block, so the comparison needs no final permutation and no
+ * transposition. Since L16 = R15, the check starts in round 15: the last
+ * two rounds are computed one S-box at a time, each S-box output is
+ * compared with the 4 target bits it produces, and the batch is abandoned
+ * as soon as every lane has mismatched. With 64 lanes that typically
+ * happens after 2-3 S-boxes of round 15, skipping most of the last two
+ * rounds.
+ *
+ * @param ctx Search context (known_block must be set)
+ * @param K Bitsliced key words of the batch
+ * @param alive Input: candidate lanes; output: lanes whose ciphertext matched
+ * @return Nonzero if any lane survived
+ */
+static BS_TARGET int BS_FN(bsFilterKnownBlock)(const BitsliceCtx *ctx, const BS_T K[56], uint64_t *alive){
+    BS_T L[32], R[32], ok;
+    BS_T *l, *r;
+    const unsigned char *km;
+    uint64_t expect = ctx->ip_blocks[ctx->known_block];
+
+    for(int i = 0; i < 32; i++){
+        L[i] = ((ctx->known_ip >> i) & 1) ? BS_ONES : BS_ZERO;
+        R[i] = ((ctx->known_ip >> (32 + i)) & 1) ? BS_ONES : BS_ZERO;
+    }
+
+    BS_FN(bsDesRounds)(K, L, R, 14, 0);
+    memcpy(&ok, alive, sizeof(BS_T));
+
+    // Round 15 turns L14 into R15 = L16, the upper half of the pre-output
+    l = L;
+    r = R;
+    km = bs_key_map[14];
+    BS_ROUND_SBOX_CHECK(1, 32);
+    BS_ROUND_SBOX_CHECK(2, 32);
+    BS_ROUND_SBOX_CHECK(3, 32);
+    BS_ROUND_SBOX_CHECK(4, 32);
+    BS_ROUND_SBOX_CHECK(5, 32);
+    BS_ROUND_SBOX_CHECK(6, 32);
+    BS_ROUND_SBOX_CHECK(7, 32);
+    BS_ROUND_SBOX_CHECK(8, 32);
+
+    // Round 16 turns R14 into R16, the lower half
+    l = R;
+    r = L;
+    km = bs_key_map[15];
+    BS_ROUND_SBOX_CHECK(1, 0);
+    BS_ROUND_SBOX_CHECK(2, 0);
+    BS_ROUND_SBOX_CHECK(3, 0);
+    BS_ROUND_SBOX_CHECK(4, 0);
+    BS_ROUND_SBOX_CHECK(5, 0);
+    BS_ROUND_SBOX_CHECK(6, 0);
+    BS_ROUND_SBOX_CHECK(7, 0);
+    BS_ROUND_SBOX_CHECK(8, 0);
+
+    memcpy(alive, &ok, sizeof(BS_T));
+    return 1;
+}
+
+/**
+ * @brief Tests a batch of consecutive keys against the ciphertext
+ *
+ * Decrypts the ciphertext blocks under all lanes of the batch, transposes
+ * the bitsliced result back into one plaintext buffer per lane and looks
+ * for the search string in each of them. In partial mode only the blocks
+ * that can decide a match are decrypted, and with a known plaintext block
+ * only lanes whose encryption of it matches the ciphertext are decrypted.
+ *
+ * @param ctx Search context (ciphertext and search string)
+ * @param work Per-thread scratch buffers
+ * @param base First key of the batch (aligned to the batch width)
+ * @param lo Lowest key of the batch that belongs to the caller's range
+ * @param hi One past the highest key that belongs to the caller's range
+ * @param match Output bitmask (BS_WORDS words), bit l set if lane l matched
+ * @return Number of matching lanes
+ */
+static BS_TARGET int BS_FN(bsSearch)(const BitsliceCtx *ctx, BitsliceWork *work,
+                                      long base, long lo, long hi, uint64_t *match){
+    BS_T K[56];
+
+    BS_FN(bsKeyWords)(base, K);
+
+    for(int w = 0; w < BS_WORDS; w++){
+        long first = base + 64L * w;
+        if(first >= lo && first + 64 <= hi){
+            match[w] = ~(uint64_t)0;
+            continue;
+        }
+        match[w] = 0;
+        for(int lane = 0; lane < 64; lane++){
+            long key = base + 64L * w + lane;
+            if(key >= lo && key < hi){
+                match[w] |= (uint64_t)1 << lane;
+            }
+        }
+    }
+
+    unsigned char done[ctx->nblocks + 1];
+    memset(done, 0, sizeof(done));
+    if(ctx->known_block >= 0){
+        if(!BS_FN(bsFilterKnownBlock)(ctx, K, match)){
+            return 0;
+        }
+    } else if(ctx->partial && BS_FN(bsFilterAtOffset)(ctx, work, K, match, done) == 0){
+        return 0;
+    }
+
+    for(int b = 0; b < ctx->nblocks; b++){
+        if(!done[b]){
+            BS_FN(bsDecryptBlock)(ctx, work, K, b);
+        }
+    }
+    return BS_FN(bsMatchLanes)(ctx, work, match);
+}
+
+#undef BS_ROUND_SBOX_CHECK
+#undef BS_CHECK_SBOX
+#undef BS_ROUND_SBOX
+#undef BS_E
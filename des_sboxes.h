@@ -0,0 +1,594 @@
+/**
+ * @file des_sboxes.h
+ * @brief Bitsliced gate circuits for the eight DES S-boxes
+ *
+ * GENERATED by gen_des_sboxes.py - do not edit by hand.
+ *
+ * Each DES_SBOXn(a1..a6, o1..o4) macro evaluates S-box n on bitsliced inputs
+ * a1..a6 (a1 = first E-expansion bit of the group) and XORs the four outputs
+ * into the lvalues o1..o4 (o1 = most significant S-box output bit). The
+ * including kernel must define BS_T and the gate macros BS_AND, BS_OR, BS_XOR,
+ * BS_ANDN(a, b) = a & ~b, BS_NOT and BS_SEL(s, a, b) = s ? b : a.
+ */
+
+#ifndef DES_SBOXES_H
+#define DES_SBOXES_H
+
+/* S1: 71 gates (117 scalar ops) */
+#define DES_SBOX1(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_NOT(a5); \
+    BS_T t1 = BS_XOR(t0, a2); \
+    BS_T t2 = BS_SEL(a3, t1, a5); \
+    BS_T t3 = BS_NOT(a2); \
+    BS_T t4 = BS_AND(a5, a3); \
+    BS_T t5 = BS_XOR(t1, t4); \
+    BS_T t6 = BS_SEL(a4, t2, t5); \
+    BS_T t7 = BS_NOT(t2); \
+    BS_T t8 = BS_AND(t0, a3); \
+    BS_T t9 = BS_XOR(a2, t8); \
+    BS_T t10 = BS_SEL(a4, t7, t9); \
+    BS_T t11 = BS_SEL(a6, t6, t10); \
+    BS_T t12 = BS_ANDN(a2, t0); \
+    BS_T t13 = BS_NOT(t12); \
+    BS_T t14 = BS_ANDN(a5, a2); \
+    BS_T t15 = BS_XOR(t13, t8); \
+    BS_T t16 = BS_SEL(a4, t9, t15); \
+    BS_T t17 = BS_ANDN(a2, a5); \
+    BS_T t18 = BS_NOT(t17); \
+    BS_T t19 = BS_NOT(t1); \
+    BS_T t20 = BS_SEL(a3, t18, t19); \
+    BS_T t21 = BS_SEL(a3, t1, t12); \
+    BS_T t22 = BS_SEL(a4, t20, t21); \
+    BS_T t23 = BS_SEL(a6, t16, t22); \
+    BS_T t24 = BS_SEL(a1, t11, t23); \
+    BS_T t25 = BS_NOT(t9); \
+    BS_T t26 = BS_NOT(t14); \
+    BS_T t27 = BS_XOR(t26, t8); \
+    BS_T t28 = BS_SEL(a4, t25, t27); \
+    BS_T t29 = BS_AND(t3, a3); \
+    BS_T t30 = BS_XOR(a5, t29); \
+    BS_T t31 = BS_ANDN(t0, a2); \
+    BS_T t32 = BS_AND(t19, a3); \
+    BS_T t33 = BS_XOR(t13, t32); \
+    BS_T t34 = BS_AND(t27, a4); \
+    BS_T t35 = BS_XOR(t30, t34); \
+    BS_T t36 = BS_SEL(a6, t28, t35); \
+    BS_T t37 = BS_SEL(a3, t26, t3); \
+    BS_T t38 = BS_AND(t26, a3); \
+    BS_T t39 = BS_XOR(t1, t38); \
+    BS_T t40 = BS_SEL(a4, t37, t39); \
+    BS_T t41 = BS_XOR(t33, a4); \
+    BS_T t42 = BS_SEL(a6, t40, t41); \
+    BS_T t43 = BS_SEL(a1, t36, t42); \
+    BS_T t44 = BS_AND(t2, a4); \
+    BS_T t45 = BS_XOR(t37, t44); \
+    BS_T t46 = BS_NOT(t31); \
+    BS_T t47 = BS_XOR(t46, t38); \
+    BS_T t48 = BS_AND(t13, a4); \
+    BS_T t49 = BS_XOR(t47, t48); \
+    BS_T t50 = BS_SEL(a6, t45, t49); \
+    BS_T t51 = BS_XOR(t17, t4); \
+    BS_T t52 = BS_AND(t26, a4); \
+    BS_T t53 = BS_XOR(t51, t52); \
+    BS_T t54 = BS_AND(t15, a4); \
+    BS_T t55 = BS_XOR(t39, t54); \
+    BS_T t56 = BS_SEL(a6, t53, t55); \
+    BS_T t57 = BS_SEL(a1, t50, t56); \
+    BS_T t58 = BS_XOR(t3, t4); \
+    BS_T t59 = BS_XOR(t51, t48); \
+    BS_T t60 = BS_NOT(t37); \
+    BS_T t61 = BS_AND(t18, a4); \
+    BS_T t62 = BS_XOR(t60, t61); \
+    BS_T t63 = BS_SEL(a6, t59, t62); \
+    BS_T t64 = BS_NOT(t58); \
+    BS_T t65 = BS_SEL(a4, t7, t64); \
+    BS_T t66 = BS_XOR(t26, a3); \
+    BS_T t67 = BS_AND(t1, a4); \
+    BS_T t68 = BS_XOR(t66, t67); \
+    BS_T t69 = BS_SEL(a6, t65, t68); \
+    BS_T t70 = BS_SEL(a1, t63, t69); \
+    o1 = BS_XOR(o1, t24); \
+    o2 = BS_XOR(o2, t43); \
+    o3 = BS_XOR(o3, t57); \
+    o4 = BS_XOR(o4, t70); \
+} while(0)
+
+/* S2: 66 gates (108 scalar ops) */
+#define DES_SBOX2(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_NOT(a5); \
+    BS_T t1 = BS_XOR(t0, a3); \
+    BS_T t2 = BS_NOT(t1); \
+    BS_T t3 = BS_XOR(t1, a6); \
+    BS_T t4 = BS_NOT(a3); \
+    BS_T t5 = BS_AND(a5, a4); \
+    BS_T t6 = BS_XOR(t3, t5); \
+    BS_T t7 = BS_ANDN(a3, a5); \
+    BS_T t8 = BS_NOT(t7); \
+    BS_T t9 = BS_SEL(a6, t2, t8); \
+    BS_T t10 = BS_ANDN(t0, a3); \
+    BS_T t11 = BS_SEL(a6, t2, t10); \
+    BS_T t12 = BS_SEL(a4, t9, t11); \
+    BS_T t13 = BS_SEL(a1, t6, t12); \
+    BS_T t14 = BS_AND(a3, a6); \
+    BS_T t15 = BS_XOR(t0, t14); \
+    BS_T t16 = BS_XOR(t15, a4); \
+    BS_T t17 = BS_XOR(t11, a4); \
+    BS_T t18 = BS_SEL(a1, t16, t17); \
+    BS_T t19 = BS_SEL(a2, t13, t18); \
+    BS_T t20 = BS_AND(t4, a6); \
+    BS_T t21 = BS_XOR(t0, t20); \
+    BS_T t22 = BS_AND(t10, a6); \
+    BS_T t23 = BS_XOR(a5, t22); \
+    BS_T t24 = BS_SEL(a4, t21, t23); \
+    BS_T t25 = BS_XOR(t24, a1); \
+    BS_T t26 = BS_XOR(t2, t20); \
+    BS_T t27 = BS_AND(a3, a5); \
+    BS_T t28 = BS_SEL(a6, t2, t27); \
+    BS_T t29 = BS_SEL(a4, t26, t28); \
+    BS_T t30 = BS_AND(t8, a6); \
+    BS_T t31 = BS_XOR(t10, t30); \
+    BS_T t32 = BS_XOR(t8, t14); \
+    BS_T t33 = BS_SEL(a4, t31, t32); \
+    BS_T t34 = BS_SEL(a1, t29, t33); \
+    BS_T t35 = BS_SEL(a2, t25, t34); \
+    BS_T t36 = BS_OR(t0, a3); \
+    BS_T t37 = BS_AND(t32, a4); \
+    BS_T t38 = BS_XOR(t36, t37); \
+    BS_T t39 = BS_AND(a5, a6); \
+    BS_T t40 = BS_XOR(t2, t39); \
+    BS_T t41 = BS_AND(t0, a4); \
+    BS_T t42 = BS_XOR(t40, t41); \
+    BS_T t43 = BS_SEL(a1, t38, t42); \
+    BS_T t44 = BS_NOT(t36); \
+    BS_T t45 = BS_AND(t2, a6); \
+    BS_T t46 = BS_XOR(t44, t45); \
+    BS_T t47 = BS_SEL(a4, t46, t3); \
+    BS_T t48 = BS_XOR(t27, t30); \
+    BS_T t49 = BS_AND(t2, a4); \
+    BS_T t50 = BS_XOR(t48, t49); \
+    BS_T t51 = BS_SEL(a1, t47, t50); \
+    BS_T t52 = BS_SEL(a2, t43, t51); \
+    BS_T t53 = BS_XOR(t7, t45); \
+    BS_T t54 = BS_SEL(a4, t32, t53); \
+    BS_T t55 = BS_AND(a6, t36); \
+    BS_T t56 = BS_XOR(t55, a4); \
+    BS_T t57 = BS_SEL(a1, t54, t56); \
+    BS_T t58 = BS_XOR(t4, t30); \
+    BS_T t59 = BS_XOR(t58, t41); \
+    BS_T t60 = BS_AND(t7, a6); \
+    BS_T t61 = BS_XOR(t36, t60); \
+    BS_T t62 = BS_XOR(t27, t22); \
+    BS_T t63 = BS_SEL(a4, t61, t62); \
+    BS_T t64 = BS_SEL(a1, t59, t63); \
+    BS_T t65 = BS_SEL(a2, t57, t64); \
+    o1 = BS_XOR(o1, t19); \
+    o2 = BS_XOR(o2, t35); \
+    o3 = BS_XOR(o3, t52); \
+    o4 = BS_XOR(o4, t65); \
+} while(0)
+
+/* S3: 64 gates (110 scalar ops) */
+#define DES_SBOX3(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_NOT(a5); \
+    BS_T t1 = BS_ANDN(t0, a3); \
+    BS_T t2 = BS_XOR(a5, a3); \
+    BS_T t3 = BS_SEL(a2, t1, t2); \
+    BS_T t4 = BS_NOT(t1); \
+    BS_T t5 = BS_XOR(t1, a2); \
+    BS_T t6 = BS_SEL(a6, t3, t5); \
+    BS_T t7 = BS_ANDN(a3, t0); \
+    BS_T t8 = BS_NOT(t7); \
+    BS_T t9 = BS_NOT(t2); \
+    BS_T t10 = BS_AND(t4, a2); \
+    BS_T t11 = BS_XOR(t8, t10); \
+    BS_T t12 = BS_AND(a3, a2); \
+    BS_T t13 = BS_XOR(a5, t12); \
+    BS_T t14 = BS_SEL(a6, t11, t13); \
+    BS_T t15 = BS_SEL(a4, t6, t14); \
+    BS_T t16 = BS_OR(t0, a3); \
+    BS_T t17 = BS_SEL(a2, t16, t9); \
+    BS_T t18 = BS_SEL(a6, t17, t13); \
+    BS_T t19 = BS_XOR(t18, a4); \
+    BS_T t20 = BS_SEL(a1, t15, t19); \
+    BS_T t21 = BS_AND(a3, t0); \
+    BS_T t22 = BS_XOR(t21, t10); \
+    BS_T t23 = BS_NOT(t21); \
+    BS_T t24 = BS_XOR(t23, a2); \
+    BS_T t25 = BS_SEL(a6, t22, t24); \
+    BS_T t26 = BS_NOT(a3); \
+    BS_T t27 = BS_AND(t16, a2); \
+    BS_T t28 = BS_XOR(t4, t27); \
+    BS_T t29 = BS_AND(t26, a2); \
+    BS_T t30 = BS_XOR(t21, t29); \
+    BS_T t31 = BS_SEL(a6, t28, t30); \
+    BS_T t32 = BS_SEL(a4, t25, t31); \
+    BS_T t33 = BS_XOR(t24, a6); \
+    BS_T t34 = BS_SEL(a6, t5, t9); \
+    BS_T t35 = BS_SEL(a4, t33, t34); \
+    BS_T t36 = BS_SEL(a1, t32, t35); \
+    BS_T t37 = BS_AND(t9, a2); \
+    BS_T t38 = BS_XOR(t16, t37); \
+    BS_T t39 = BS_XOR(t2, a2); \
+    BS_T t40 = BS_SEL(a6, t38, t39); \
+    BS_T t41 = BS_AND(a5, a2); \
+    BS_T t42 = BS_XOR(a3, t41); \
+    BS_T t43 = BS_SEL(a6, t2, t42); \
+    BS_T t44 = BS_SEL(a4, t40, t43); \
+    BS_T t45 = BS_XOR(a5, t29); \
+    BS_T t46 = BS_SEL(a6, t45, t2); \
+    BS_T t47 = BS_XOR(t21, t37); \
+    BS_T t48 = BS_XOR(t7, a2); \
+    BS_T t49 = BS_SEL(a6, t47, t48); \
+    BS_T t50 = BS_SEL(a4, t46, t49); \
+    BS_T t51 = BS_SEL(a1, t44, t50); \
+    BS_T t52 = BS_XOR(t48, a6); \
+    BS_T t53 = BS_AND(t0, a4); \
+    BS_T t54 = BS_XOR(t52, t53); \
+    BS_T t55 = BS_XOR(t9, t10); \
+    BS_T t56 = BS_AND(t37, a6); \
+    BS_T t57 = BS_XOR(t55, t56); \
+    BS_T t58 = BS_NOT(t55); \
+    BS_T t59 = BS_AND(t23, a2); \
+    BS_T t60 = BS_XOR(t9, t59); \
+    BS_T t61 = BS_SEL(a6, t58, t60); \
+    BS_T t62 = BS_SEL(a4, t57, t61); \
+    BS_T t63 = BS_SEL(a1, t54, t62); \
+    o1 = BS_XOR(o1, t20); \
+    o2 = BS_XOR(o2, t36); \
+    o3 = BS_XOR(o3, t51); \
+    o4 = BS_XOR(o4, t63); \
+} while(0)
+
+/* S4: 47 gates (75 scalar ops) */
+#define DES_SBOX4(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_ANDN(a5, a3); \
+    BS_T t1 = BS_NOT(t0); \
+    BS_T t2 = BS_XOR(t0, a1); \
+    BS_T t3 = BS_NOT(a5); \
+    BS_T t4 = BS_XOR(t3, a3); \
+    BS_T t5 = BS_SEL(a1, t1, t4); \
+    BS_T t6 = BS_SEL(a4, t2, t5); \
+    BS_T t7 = BS_ANDN(t3, a3); \
+    BS_T t8 = BS_AND(t1, a1); \
+    BS_T t9 = BS_XOR(a3, t8); \
+    BS_T t10 = BS_XOR(t4, a1); \
+    BS_T t11 = BS_SEL(a4, t9, t10); \
+    BS_T t12 = BS_SEL(a2, t6, t11); \
+    BS_T t13 = BS_ANDN(a3, a5); \
+    BS_T t14 = BS_NOT(t13); \
+    BS_T t15 = BS_XOR(t14, t8); \
+    BS_T t16 = BS_AND(a5, a4); \
+    BS_T t17 = BS_XOR(t15, t16); \
+    BS_T t18 = BS_AND(a3, a5); \
+    BS_T t19 = BS_XOR(t18, t8); \
+    BS_T t20 = BS_NOT(t7); \
+    BS_T t21 = BS_AND(t13, a1); \
+    BS_T t22 = BS_XOR(t20, t21); \
+    BS_T t23 = BS_SEL(a4, t19, t22); \
+    BS_T t24 = BS_SEL(a2, t17, t23); \
+    BS_T t25 = BS_SEL(a6, t12, t24); \
+    BS_T t26 = BS_NOT(t12); \
+    BS_T t27 = BS_SEL(a6, t24, t26); \
+    BS_T t28 = BS_AND(t0, a1); \
+    BS_T t29 = BS_XOR(t4, t28); \
+    BS_T t30 = BS_XOR(t14, a1); \
+    BS_T t31 = BS_SEL(a4, t29, t30); \
+    BS_T t32 = BS_NOT(t10); \
+    BS_T t33 = BS_AND(t14, a1); \
+    BS_T t34 = BS_AND(t22, a4); \
+    BS_T t35 = BS_XOR(t32, t34); \
+    BS_T t36 = BS_SEL(a2, t31, t35); \
+    BS_T t37 = BS_XOR(a3, t33); \
+    BS_T t38 = BS_AND(t3, a4); \
+    BS_T t39 = BS_XOR(t37, t38); \
+    BS_T t40 = BS_XOR(a5, t28); \
+    BS_T t41 = BS_XOR(t3, t33); \
+    BS_T t42 = BS_SEL(a4, t40, t41); \
+    BS_T t43 = BS_SEL(a2, t39, t42); \
+    BS_T t44 = BS_SEL(a6, t36, t43); \
+    BS_T t45 = BS_NOT(t43); \
+    BS_T t46 = BS_SEL(a6, t45, t36); \
+    o1 = BS_XOR(o1, t25); \
+    o2 = BS_XOR(o2, t27); \
+    o3 = BS_XOR(o3, t44); \
+    o4 = BS_XOR(o4, t46); \
+} while(0)
+
+/* S5: 73 gates (119 scalar ops) */
+#define DES_SBOX5(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_NOT(a1); \
+    BS_T t1 = BS_AND(a5, t0); \
+    BS_T t2 = BS_NOT(t1); \
+    BS_T t3 = BS_XOR(t1, a2); \
+    BS_T t4 = BS_AND(a5, a1); \
+    BS_T t5 = BS_ANDN(a2, t4); \
+    BS_T t6 = BS_NOT(t5); \
+    BS_T t7 = BS_SEL(a6, t3, t6); \
+    BS_T t8 = BS_OR(a1, a5); \
+    BS_T t9 = BS_NOT(t8); \
+    BS_T t10 = BS_XOR(t8, a2); \
+    BS_T t11 = BS_XOR(a1, a5); \
+    BS_T t12 = BS_AND(t8, a2); \
+    BS_T t13 = BS_XOR(t4, t12); \
+    BS_T t14 = BS_SEL(a6, t10, t13); \
+    BS_T t15 = BS_SEL(a3, t7, t14); \
+    BS_T t16 = BS_OR(t0, a5); \
+    BS_T t17 = BS_AND(t2, a2); \
+    BS_T t18 = BS_XOR(t11, t17); \
+    BS_T t19 = BS_SEL(a6, t13, t18); \
+    BS_T t20 = BS_NOT(t11); \
+    BS_T t21 = BS_AND(t1, a2); \
+    BS_T t22 = BS_XOR(t20, t21); \
+    BS_T t23 = BS_AND(t4, a2); \
+    BS_T t24 = BS_XOR(t20, t23); \
+    BS_T t25 = BS_SEL(a6, t22, t24); \
+    BS_T t26 = BS_SEL(a3, t19, t25); \
+    BS_T t27 = BS_SEL(a4, t15, t26); \
+    BS_T t28 = BS_AND(a1, a2); \
+    BS_T t29 = BS_XOR(t9, t28); \
+    BS_T t30 = BS_SEL(a6, t11, t29); \
+    BS_T t31 = BS_NOT(a5); \
+    BS_T t32 = BS_XOR(t20, t28); \
+    BS_T t33 = BS_AND(t3, a6); \
+    BS_T t34 = BS_XOR(t32, t33); \
+    BS_T t35 = BS_SEL(a3, t30, t34); \
+    BS_T t36 = BS_NOT(t10); \
+    BS_T t37 = BS_XOR(t36, a6); \
+    BS_T t38 = BS_XOR(t11, a2); \
+    BS_T t39 = BS_XOR(t38, a6); \
+    BS_T t40 = BS_SEL(a3, t37, t39); \
+    BS_T t41 = BS_SEL(a4, t35, t40); \
+    BS_T t42 = BS_NOT(t18); \
+    BS_T t43 = BS_NOT(t4); \
+    BS_T t44 = BS_AND(t16, a2); \
+    BS_T t45 = BS_XOR(t43, t44); \
+    BS_T t46 = BS_SEL(a6, t42, t45); \
+    BS_T t47 = BS_XOR(a5, a2); \
+    BS_T t48 = BS_SEL(a6, t45, t47); \
+    BS_T t49 = BS_SEL(a3, t46, t48); \
+    BS_T t50 = BS_NOT(t45); \
+    BS_T t51 = BS_AND(a5, a2); \
+    BS_T t52 = BS_XOR(t20, t51); \
+    BS_T t53 = BS_SEL(a6, t50, t52); \
+    BS_T t54 = BS_NOT(t13); \
+    BS_T t55 = BS_AND(t0, a6); \
+    BS_T t56 = BS_XOR(t54, t55); \
+    BS_T t57 = BS_SEL(a3, t53, t56); \
+    BS_T t58 = BS_SEL(a4, t49, t57); \
+    BS_T t59 = BS_SEL(a6, t12, t38); \
+    BS_T t60 = BS_AND(t31, a2); \
+    BS_T t61 = BS_XOR(t11, t60); \
+    BS_T t62 = BS_SEL(a6, t20, t61); \
+    BS_T t63 = BS_SEL(a3, t59, t62); \
+    BS_T t64 = BS_XOR(t8, t60); \
+    BS_T t65 = BS_AND(t9, a2); \
+    BS_T t66 = BS_XOR(t4, t65); \
+    BS_T t67 = BS_SEL(a6, t64, t66); \
+    BS_T t68 = BS_XOR(t31, t5); \
+    BS_T t69 = BS_AND(t8, a6); \
+    BS_T t70 = BS_XOR(t68, t69); \
+    BS_T t71 = BS_SEL(a3, t67, t70); \
+    BS_T t72 = BS_SEL(a4, t63, t71); \
+    o1 = BS_XOR(o1, t27); \
+    o2 = BS_XOR(o2, t41); \
+    o3 = BS_XOR(o3, t58); \
+    o4 = BS_XOR(o4, t72); \
+} while(0)
+
+/* S6: 65 gates (115 scalar ops) */
+#define DES_SBOX6(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_NOT(a5); \
+    BS_T t1 = BS_XOR(t0, a2); \
+    BS_T t2 = BS_NOT(a2); \
+    BS_T t3 = BS_AND(a5, a6); \
+    BS_T t4 = BS_XOR(t1, t3); \
+    BS_T t5 = BS_XOR(t0, a6); \
+    BS_T t6 = BS_SEL(a3, t4, t5); \
+    BS_T t7 = BS_XOR(t2, a6); \
+    BS_T t8 = BS_AND(t2, a6); \
+    BS_T t9 = BS_XOR(a5, t8); \
+    BS_T t10 = BS_SEL(a3, t7, t9); \
+    BS_T t11 = BS_SEL(a4, t6, t10); \
+    BS_T t12 = BS_ANDN(t0, a2); \
+    BS_T t13 = BS_SEL(a6, a5, t12); \
+    BS_T t14 = BS_SEL(a3, t7, t13); \
+    BS_T t15 = BS_ANDN(a5, a2); \
+    BS_T t16 = BS_SEL(a6, t1, t15); \
+    BS_T t17 = BS_OR(t0, a6); \
+    BS_T t18 = BS_SEL(a3, t16, t17); \
+    BS_T t19 = BS_SEL(a4, t14, t18); \
+    BS_T t20 = BS_SEL(a1, t11, t19); \
+    BS_T t21 = BS_NOT(t1); \
+    BS_T t22 = BS_XOR(t1, a6); \
+    BS_T t23 = BS_NOT(t7); \
+    BS_T t24 = BS_AND(t0, a3); \
+    BS_T t25 = BS_XOR(t22, t24); \
+    BS_T t26 = BS_NOT(t15); \
+    BS_T t27 = BS_SEL(a6, a5, t26); \
+    BS_T t28 = BS_XOR(t27, a3); \
+    BS_T t29 = BS_SEL(a4, t25, t28); \
+    BS_T t30 = BS_NOT(t22); \
+    BS_T t31 = BS_AND(a2, a5); \
+    BS_T t32 = BS_SEL(a6, t31, t21); \
+    BS_T t33 = BS_SEL(a3, t30, t32); \
+    BS_T t34 = BS_NOT(t31); \
+    BS_T t35 = BS_AND(t26, a6); \
+    BS_T t36 = BS_XOR(t34, t35); \
+    BS_T t37 = BS_SEL(a3, t36, t1); \
+    BS_T t38 = BS_SEL(a4, t33, t37); \
+    BS_T t39 = BS_SEL(a1, t29, t38); \
+    BS_T t40 = BS_AND(a6, t34); \
+    BS_T t41 = BS_NOT(t12); \
+    BS_T t42 = BS_AND(t41, a3); \
+    BS_T t43 = BS_XOR(t40, t42); \
+    BS_T t44 = BS_XOR(t36, t42); \
+    BS_T t45 = BS_SEL(a4, t43, t44); \
+    BS_T t46 = BS_AND(t31, a6); \
+    BS_T t47 = BS_XOR(t21, t46); \
+    BS_T t48 = BS_AND(t36, a3); \
+    BS_T t49 = BS_XOR(t47, t48); \
+    BS_T t50 = BS_XOR(t1, t48); \
+    BS_T t51 = BS_SEL(a4, t49, t50); \
+    BS_T t52 = BS_SEL(a1, t45, t51); \
+    BS_T t53 = BS_AND(t2, a3); \
+    BS_T t54 = BS_XOR(a5, t53); \
+    BS_T t55 = BS_AND(t15, a6); \
+    BS_T t56 = BS_XOR(t21, t55); \
+    BS_T t57 = BS_SEL(a6, a2, t34); \
+    BS_T t58 = BS_SEL(a3, t56, t57); \
+    BS_T t59 = BS_SEL(a4, t54, t58); \
+    BS_T t60 = BS_NOT(t9); \
+    BS_T t61 = BS_SEL(a3, t60, t23); \
+    BS_T t62 = BS_XOR(t7, t24); \
+    BS_T t63 = BS_SEL(a4, t61, t62); \
+    BS_T t64 = BS_SEL(a1, t59, t63); \
+    o1 = BS_XOR(o1, t20); \
+    o2 = BS_XOR(o2, t39); \
+    o3 = BS_XOR(o3, t52); \
+    o4 = BS_XOR(o4, t64); \
+} while(0)
+
+/* S7: 63 gates (107 scalar ops) */
+#define DES_SBOX7(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_NOT(a5); \
+    BS_T t1 = BS_XOR(a5, a2); \
+    BS_T t2 = BS_AND(a2, a4); \
+    BS_T t3 = BS_XOR(a5, t2); \
+    BS_T t4 = BS_NOT(t1); \
+    BS_T t5 = BS_NOT(a2); \
+    BS_T t6 = BS_AND(a5, a4); \
+    BS_T t7 = BS_XOR(t4, t6); \
+    BS_T t8 = BS_SEL(a3, t3, t7); \
+    BS_T t9 = BS_ANDN(a2, a5); \
+    BS_T t10 = BS_NOT(t9); \
+    BS_T t11 = BS_SEL(a4, a2, t10); \
+    BS_T t12 = BS_ANDN(t0, a2); \
+    BS_T t13 = BS_SEL(a4, t12, t1); \
+    BS_T t14 = BS_SEL(a3, t11, t13); \
+    BS_T t15 = BS_SEL(a1, t8, t14); \
+    BS_T t16 = BS_NOT(t3); \
+    BS_T t17 = BS_XOR(t16, a3); \
+    BS_T t18 = BS_SEL(a4, t1, t10); \
+    BS_T t19 = BS_SEL(a4, t9, t4); \
+    BS_T t20 = BS_SEL(a3, t18, t19); \
+    BS_T t21 = BS_SEL(a1, t17, t20); \
+    BS_T t22 = BS_SEL(a6, t15, t21); \
+    BS_T t23 = BS_AND(t5, a4); \
+    BS_T t24 = BS_XOR(t4, t23); \
+    BS_T t25 = BS_AND(a2, a3); \
+    BS_T t26 = BS_XOR(t24, t25); \
+    BS_T t27 = BS_SEL(a1, t26, t8); \
+    BS_T t28 = BS_NOT(t12); \
+    BS_T t29 = BS_AND(t10, a4); \
+    BS_T t30 = BS_XOR(t0, t29); \
+    BS_T t31 = BS_AND(t12, a4); \
+    BS_T t32 = BS_XOR(t4, t31); \
+    BS_T t33 = BS_SEL(a3, t30, t32); \
+    BS_T t34 = BS_XOR(t1, t2); \
+    BS_T t35 = BS_SEL(a3, t4, t34); \
+    BS_T t36 = BS_SEL(a1, t33, t35); \
+    BS_T t37 = BS_SEL(a6, t27, t36); \
+    BS_T t38 = BS_XOR(t18, a3); \
+    BS_T t39 = BS_AND(t4, a4); \
+    BS_T t40 = BS_XOR(a2, t39); \
+    BS_T t41 = BS_AND(t28, a3); \
+    BS_T t42 = BS_XOR(t40, t41); \
+    BS_T t43 = BS_SEL(a1, t38, t42); \
+    BS_T t44 = BS_XOR(a2, a4); \
+    BS_T t45 = BS_AND(t39, a3); \
+    BS_T t46 = BS_XOR(t44, t45); \
+    BS_T t47 = BS_XOR(t5, t29); \
+    BS_T t48 = BS_XOR(t47, a3); \
+    BS_T t49 = BS_SEL(a1, t46, t48); \
+    BS_T t50 = BS_SEL(a6, t43, t49); \
+    BS_T t51 = BS_NOT(t7); \
+    BS_T t52 = BS_XOR(t0, a4); \
+    BS_T t53 = BS_SEL(a3, t51, t52); \
+    BS_T t54 = BS_XOR(t53, a1); \
+    BS_T t55 = BS_AND(t28, a4); \
+    BS_T t56 = BS_XOR(t4, t55); \
+    BS_T t57 = BS_NOT(t30); \
+    BS_T t58 = BS_SEL(a3, t56, t57); \
+    BS_T t59 = BS_NOT(t13); \
+    BS_T t60 = BS_XOR(t59, a3); \
+    BS_T t61 = BS_SEL(a1, t58, t60); \
+    BS_T t62 = BS_SEL(a6, t54, t61); \
+    o1 = BS_XOR(o1, t22); \
+    o2 = BS_XOR(o2, t37); \
+    o3 = BS_XOR(o3, t50); \
+    o4 = BS_XOR(o4, t62); \
+} while(0)
+
+/* S8: 64 gates (98 scalar ops) */
+#define DES_SBOX8(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \
+    BS_T t0 = BS_ANDN(a5, a2); \
+    BS_T t1 = BS_NOT(t0); \
+    BS_T t2 = BS_XOR(t1, a3); \
+    BS_T t3 = BS_NOT(a2); \
+    BS_T t4 = BS_XOR(t3, a5); \
+    BS_T t5 = BS_NOT(a5); \
+    BS_T t6 = BS_AND(a2, a3); \
+    BS_T t7 = BS_XOR(t4, t6); \
+    BS_T t8 = BS_SEL(a4, t2, t7); \
+    BS_T t9 = BS_ANDN(a5, t3); \
+    BS_T t10 = BS_NOT(t9); \
+    BS_T t11 = BS_AND(t5, a3); \
+    BS_T t12 = BS_XOR(t0, t11); \
+    BS_T t13 = BS_XOR(a2, t11); \
+    BS_T t14 = BS_SEL(a4, t12, t13); \
+    BS_T t15 = BS_SEL(a1, t8, t14); \
+    BS_T t16 = BS_NOT(t4); \
+    BS_T t17 = BS_XOR(t16, a3); \
+    BS_T t18 = BS_OR(t3, a5); \
+    BS_T t19 = BS_AND(t1, a4); \
+    BS_T t20 = BS_XOR(t17, t19); \
+    BS_T t21 = BS_SEL(a3, a2, t0); \
+    BS_T t22 = BS_AND(t4, a4); \
+    BS_T t23 = BS_XOR(t21, t22); \
+    BS_T t24 = BS_SEL(a1, t20, t23); \
+    BS_T t25 = BS_SEL(a6, t15, t24); \
+    BS_T t26 = BS_ANDN(t3, a5); \
+    BS_T t27 = BS_AND(t16, a3); \
+    BS_T t28 = BS_XOR(t26, t27); \
+    BS_T t29 = BS_AND(t18, a4); \
+    BS_T t30 = BS_XOR(t28, t29); \
+    BS_T t31 = BS_NOT(t17); \
+    BS_T t32 = BS_SEL(a4, t31, t7); \
+    BS_T t33 = BS_SEL(a1, t30, t32); \
+    BS_T t34 = BS_NOT(t30); \
+    BS_T t35 = BS_XOR(t13, a4); \
+    BS_T t36 = BS_SEL(a1, t34, t35); \
+    BS_T t37 = BS_SEL(a6, t33, t36); \
+    BS_T t38 = BS_XOR(t16, t11); \
+    BS_T t39 = BS_AND(a5, a4); \
+    BS_T t40 = BS_XOR(t38, t39); \
+    BS_T t41 = BS_AND(t10, a3); \
+    BS_T t42 = BS_XOR(t18, t41); \
+    BS_T t43 = BS_XOR(t42, a4); \
+    BS_T t44 = BS_SEL(a1, t40, t43); \
+    BS_T t45 = BS_AND(t4, a3); \
+    BS_T t46 = BS_XOR(t0, t45); \
+    BS_T t47 = BS_SEL(a4, t46, t13); \
+    BS_T t48 = BS_AND(t3, a3); \
+    BS_T t49 = BS_XOR(t5, t48); \
+    BS_T t50 = BS_XOR(t3, a3); \
+    BS_T t51 = BS_SEL(a4, t49, t50); \
+    BS_T t52 = BS_SEL(a1, t47, t51); \
+    BS_T t53 = BS_SEL(a6, t44, t52); \
+    BS_T t54 = BS_NOT(t24); \
+    BS_T t55 = BS_XOR(t18, t45); \
+    BS_T t56 = BS_AND(t12, a4); \
+    BS_T t57 = BS_XOR(t55, t56); \
+    BS_T t58 = BS_AND(a5, a3); \
+    BS_T t59 = BS_XOR(t16, t58); \
+    BS_T t60 = BS_AND(t27, a4); \
+    BS_T t61 = BS_XOR(t59, t60); \
+    BS_T t62 = BS_SEL(a1, t57, t61); \
+    BS_T t63 = BS_SEL(a6, t54, t62); \
+    o1 = BS_XOR(o1, t25); \
+    o2 = BS_XOR(o2, t37); \
+    o3 = BS_XOR(o3, t53); \
+    o4 = BS_XOR(o4, t63); \
+} while(0)
+
+#endif /* DES_SBOXES_H */
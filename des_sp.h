@@ -0,0 +1,273 @@
+/**
+ * @file des_sp.h
+ * @brief Table-driven scalar DES core with interleaved keys
+ *
+ * A plain C implementation of DES for the key search: each round folds the
+ * S-boxes and the P permutation into eight 64-entry "SP" tables (2 KB in
+ * total, so they stay in L1), and the initial and final permutations are
+ * done with the usual swap-and-mask sequence instead of bit tables.
+ *
+ * DES rounds form one long dependency chain, so a single key leaves most of
+ * the core idle waiting on table loads. spCrypt runs DES_SP_WAYS independent
+ * keys side by side so their loads overlap.
+ *
+ * Halves are 32-bit words with DES bit 1 of the half in the most significant
+ * bit. Subkeys are stored pre-aligned to the rotated R words they are XORed
+ * with, so the round function only shifts and masks.
+ */
+
+#ifndef DES_SP_H
+#define DES_SP_H
+
+#include <stdint.h>
+#include "des_tables.h"
+
+/** Number of keys processed together by spCrypt */
+#define DES_SP_WAYS 4
+
+/**
+ * @brief Expanded key: per round, the odd and even S-box subkey chunks
+ *
+ * k[round][0] holds the chunks of S-boxes 1, 3, 5, 7 and k[round][1] those
+ * of S-boxes 2, 4, 6, 8, each 6-bit chunk at bits 26, 18, 10 and 2.
+ */
+typedef struct {
+    uint32_t k[16][2];
+} SpSchedule;
+
+/** S-box n followed by P: output word for each 6-bit input */
+static uint32_t sp_table[8][64];
+/** PC1 bits contributed by each 7-bit group of the search key, as C << 28 | D */
+static uint64_t sp_pc1[8][128];
+/** Subkey words contributed by each 7-bit group of C << 28 | D, as k0 << 32 | k1 */
+static uint64_t sp_pc2[8][128];
+/** Key schedules of keys 0 .. DES_SP_WAYS-1, the XOR deltas within an aligned batch */
+static SpSchedule sp_way_delta[DES_SP_WAYS];
+
+/** Swaps the bits of a selected by m << n with the bits of b selected by m */
+#define SP_PERM(a, b, n, m) do { \
+    uint32_t t_ = (((a) >> (n)) ^ (b)) & (m); \
+    (b) ^= t_; \
+    (a) ^= t_ << (n); \
+} while(0)
+
+/** Round function f(R, K) on a right half */
+#define SP_F(r, kk) ({ \
+    uint32_t x_ = (((r) >> 1) | ((r) << 31)) ^ (kk)[0]; \
+    uint32_t y_ = (((r) << 3) | ((r) >> 29)) ^ (kk)[1]; \
+    sp_table[0][(x_ >> 26) & 63] ^ sp_table[2][(x_ >> 18) & 63] ^ \
+    sp_table[4][(x_ >> 10) & 63] ^ sp_table[6][(x_ >> 2) & 63] ^ \
+    sp_table[1][(y_ >> 26) & 63] ^ sp_table[3][(y_ >> 18) & 63] ^ \
+    sp_table[5][(y_ >> 10) & 63] ^ sp_table[7][(y_ >> 2) & 63]; \
+})
+
+/**
+ * @brief Word bit of subkey bit i (0-based, S-box n = i / 6 + 1)
+ */
+static inline int spSubkeyShift(int i){
+    static const unsigned char chunk_shift[8] = { 26, 26, 18, 18, 10, 10, 2, 2 };
+    return chunk_shift[i / 6] + 5 - i % 6;
+}
+
+/**
+ * @brief Expands a 56-bit search key into its 16 round subkeys
+ *
+ * @param key 56-bit DES key (without parity bits), as enumerated by the search
+ * @param ks Output key schedule
+ */
+static inline void spKeySchedule(long key, SpSchedule *ks){
+    uint64_t cd = 0;
+    for(int g = 0; g < 8; g++){
+        cd |= sp_pc1[g][(key >> (7 * g)) & 127];
+    }
+
+    uint32_t c = cd >> 28, d = cd & 0xFFFFFFF;
+    for(int round = 0; round < 16; round++){
+        int s = des_shifts[round];
+        c = ((c << s) | (c >> (28 - s))) & 0xFFFFFFF;
+        d = ((d << s) | (d >> (28 - s))) & 0xFFFFFFF;
+
+        uint64_t rot = ((uint64_t)c << 28) | d, k = 0;
+        for(int g = 0; g < 8; g++){
+            k |= sp_pc2[g][(rot >> (7 * g)) & 127];
+        }
+        ks->k[round][0] = k >> 32;
+        ks->k[round][1] = (uint32_t)k;
+    }
+}
+
+/**
+ * @brief Precomputes the SP and key schedule tables
+ *
+ * Must be called once before any other sp function.
+ */
+static void spInitTables(void){
+    for(int n = 0; n < 8; n++){
+        for(int v = 0; v < 64; v++){
+            int row = ((v >> 4) & 2) | (v & 1);
+            int col = (v >> 1) & 15;
+            int s = des_sbox[n][16 * row + col];
+            uint32_t out = 0;
+            for(int j = 0; j < 4; j++){
+                if((s >> (3 - j)) & 1){
+                    // f output bit i comes from S-box output bit des_p[i]
+                    for(int i = 0; i < 32; i++){
+                        if(des_p[i] == 4 * n + j + 1){
+                            out |= (uint32_t)1 << (31 - i);
+                        }
+                    }
+                }
+            }
+            sp_table[n][v] = out;
+        }
+    }
+
+    // Search key bit s -> bit 55 - j of C << 28 | D, where des_pc1[j] is its DES key bit
+    int cd_bit[56];
+    for(int j = 0; j < 56; j++){
+        cd_bit[desKeyBitToSearchBit(des_pc1[j])] = 55 - j;
+    }
+    for(int g = 0; g < 8; g++){
+        for(int v = 0; v < 128; v++){
+            uint64_t cd = 0;
+            for(int b = 0; b < 7; b++){
+                if((v >> b) & 1){
+                    cd |= (uint64_t)1 << cd_bit[g * 7 + b];
+                }
+            }
+            sp_pc1[g][v] = cd;
+        }
+    }
+
+    // Subkey bit i is bit des_pc2[i] (1-based) of C || D, i.e. bit 56 - des_pc2[i] of C << 28 | D
+    for(int g = 0; g < 8; g++){
+        for(int v = 0; v < 128; v++){
+            uint64_t k = 0;
+            for(int i = 0; i < 48; i++){
+                int cd = 56 - des_pc2[i];
+                if(cd / 7 == g && ((v >> (cd % 7)) & 1)){
+                    k |= (uint64_t)1 << (spSubkeyShift(i) + ((i / 6) % 2 == 0 ? 32 : 0));
+                }
+            }
+            sp_pc2[g][v] = k;
+        }
+    }
+
+    for(int w = 0; w < DES_SP_WAYS; w++){
+        spKeySchedule(w, &sp_way_delta[w]);
+    }
+}
+
+/**
+ * @brief Expands the keys base .. base + DES_SP_WAYS - 1 of an aligned batch
+ *
+ * The key schedule only moves key bits around, so the schedule of
+ * (base ^ w) is the schedule of base XOR the schedule of w: one full
+ * expansion serves the whole batch.
+ *
+ * @param base First key of the batch (multiple of DES_SP_WAYS)
+ * @param ks Output key schedule of each way
+ */
+static inline void spKeyScheduleWays(long base, SpSchedule ks[DES_SP_WAYS]){
+    spKeySchedule(base, &ks[0]);
+    for(int w = 1; w < DES_SP_WAYS; w++){
+        for(int round = 0; round < 16; round++){
+            ks[w].k[round][0] = ks[0].k[round][0] ^ sp_way_delta[w].k[round][0];
+            ks[w].k[round][1] = ks[0].k[round][1] ^ sp_way_delta[w].k[round][1];
+        }
+    }
+}
+
+/**
+ * @brief Loads an 8-byte block and applies the initial permutation
+ */
+static inline void spInitialPerm(const unsigned char *in, uint32_t *l, uint32_t *r){
+    uint32_t a = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+    uint32_t b = ((uint32_t)in[4] << 24) | ((uint32_t)in[5] << 16) | ((uint32_t)in[6] << 8) | in[7];
+
+    SP_PERM(a, b, 4, 0x0F0F0F0F);
+    SP_PERM(a, b, 16, 0x0000FFFF);
+    SP_PERM(b, a, 2, 0x33333333);
+    SP_PERM(b, a, 8, 0x00FF00FF);
+    SP_PERM(a, b, 1, 0x55555555);
+    *l = a;
+    *r = b;
+}
+
+/**
+ * @brief Applies the final permutation to the pre-output block R16 || L16 and stores it
+ */
+static inline void spFinalPerm(uint32_t r16, uint32_t l16, unsigned char *out){
+    uint32_t a = r16, b = l16;
+
+    SP_PERM(a, b, 1, 0x55555555);
+    SP_PERM(b, a, 8, 0x00FF00FF);
+    SP_PERM(b, a, 2, 0x33333333);
+    SP_PERM(a, b, 16, 0x0000FFFF);
+    SP_PERM(a, b, 4, 0x0F0F0F0F);
+    for(int i = 0; i < 4; i++){
+        out[i] = a >> (24 - 8 * i);
+        out[4 + i] = b >> (24 - 8 * i);
+    }
+}
+
+/**
+ * @brief Runs the 16 DES rounds for DES_SP_WAYS keys at once
+ *
+ * On entry l and r hold each key's block after the initial permutation; on
+ * return they hold L16 and R16, so the pre-output block of key w is
+ * r[w] || l[w].
+ *
+ * @param ks Key schedule of each way
+ * @param l Left halves
+ * @param r Right halves
+ * @param decrypt Nonzero to apply the subkeys in reverse order
+ */
+static inline void spCrypt(const SpSchedule ks[DES_SP_WAYS], uint32_t l[DES_SP_WAYS],
+                           uint32_t r[DES_SP_WAYS], int decrypt){
+    for(int round = 0; round < 16; round += 2){
+        int k0 = decrypt ? 15 - round : round;
+        int k1 = decrypt ? 14 - round : round + 1;
+        for(int w = 0; w < DES_SP_WAYS; w++){
+            l[w] ^= SP_F(r[w], ks[w].k[k0]);
+        }
+        for(int w = 0; w < DES_SP_WAYS; w++){
+            r[w] ^= SP_F(l[w], ks[w].k[k1]);
+        }
+    }
+}
+
+/**
+ * @brief Decrypts ECB ciphertext under a single key
+ *
+ * ECB blocks are independent, so DES_SP_WAYS blocks are run through the
+ * rounds together, the same way spCrypt interleaves keys.
+ *
+ * @param ks Key schedule (see spKeySchedule)
+ * @param ciph Ciphertext buffer
+ * @param len Length of the ciphertext (must be multiple of 8)
+ * @param output Output buffer for the decrypted data
+ */
+static inline void spDecrypt(const SpSchedule *ks, const unsigned char *ciph, int len, unsigned char *output){
+    for(int i = 0; i < len; i += 8 * DES_SP_WAYS){
+        uint32_t l[DES_SP_WAYS] = {0}, r[DES_SP_WAYS] = {0};
+        int n = (len - i) / 8 < DES_SP_WAYS ? (len - i) / 8 : DES_SP_WAYS;
+
+        for(int w = 0; w < n; w++){
+            spInitialPerm(ciph + i + 8 * w, &l[w], &r[w]);
+        }
+        for(int round = 0; round < 16; round += 2){
+            for(int w = 0; w < DES_SP_WAYS; w++){
+                l[w] ^= SP_F(r[w], ks->k[15 - round]);
+            }
+            for(int w = 0; w < DES_SP_WAYS; w++){
+                r[w] ^= SP_F(l[w], ks->k[14 - round]);
+            }
+        }
+        for(int w = 0; w < n; w++){
+            spFinalPerm(r[w], l[w], output + i + 8 * w);
+        }
+    }
+}
+
+#endif /* DES_SP_H */
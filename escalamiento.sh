@@ -0,0 +1,184 @@
+#!/bin/bash
+
+echo "========================================================="
+echo "  Estudio de escalamiento fuerte y débil"
+echo "========================================================="
+echo ""
+
+# Configuración (se puede cambiar con variables de entorno)
+PROCS=${PROCS:-"1 2 4"}                      # Procesos MPI
+THREADS=${THREADS:-"1 2 4"}                  # Hilos OpenMP por proceso
+ENGINE=${ENGINE:-bitslice}                   # Motor de --engine
+STRONG_WINDOW=${STRONG_WINDOW:-268435456}    # Llaves totales, fijas (escalamiento fuerte)
+WEAK_WINDOW=${WEAK_WINDOW:-16777216}         # Llaves por trabajador (escalamiento débil)
+NUM_RUNS=${NUM_RUNS:-3}                      # Ejecuciones por configuración (se usa la mediana)
+MPIRUN=${MPIRUN:-"mpirun"}                   # Lanzador para más de un proceso
+
+TEST_INPUT="input.txt"
+TEST_FILE="escalamiento.bin"
+SEARCH_TEXT="message with"
+
+# Archivos de resultados
+RAW_FILE="escalamiento.csv"
+STRONG_FILE="escalamiento_fuerte.txt"
+WEAK_FILE="escalamiento_debil.txt"
+
+> "$STRONG_FILE"
+> "$WEAK_FILE"
+rm -f "$RAW_FILE"
+
+# Ejecuta un benchmark de ventana fija (--bench) y devuelve el tiempo de
+# búsqueda y la tasa serial medida en la misma corrida. Con un proceso se
+# ejecuta directamente (MPI singleton), sin lanzador
+run_bench() {
+    local procs=$1
+    local threads=$2
+    local window=$3
+    local out="escalamiento_fila.csv"
+
+    rm -f "$out"
+    if [ "$procs" -eq 1 ]; then
+        OMP_NUM_THREADS=$threads ./main_parallel "$TEST_FILE" "$SEARCH_TEXT" \
+            --engine "$ENGINE" --bench "$window" --bench-out "$out" > /dev/null 2>&1
+    else
+        OMP_NUM_THREADS=$threads $MPIRUN -np "$procs" ./main_parallel "$TEST_FILE" "$SEARCH_TEXT" \
+            --engine "$ENGINE" --bench "$window" --bench-out "$out" > /dev/null 2>&1
+    fi
+
+    if [ ! -f "$out" ]; then
+        echo ""
+        return
+    fi
+
+    # Columnas por nombre, así el orden del CSV puede cambiar
+    awk -F, 'NR == 1 { for (i = 1; i <= NF; i++) col[$i] = i; next }
+             { print $col["time_search"], $col["serial_keys_per_sec"] }' "$out"
+    if [ ! -f "$RAW_FILE" ]; then
+        head -n 1 "$out" | sed 's/^/study,/' > "$RAW_FILE"
+    fi
+    tail -n 1 "$out" | sed "s/^/$STUDY,/" >> "$RAW_FILE"
+    rm -f "$out"
+}
+
+# Mediana de los tiempos de NUM_RUNS ejecuciones: "<tiempo> <tasa serial>"
+median_bench() {
+    local procs=$1
+    local threads=$2
+    local window=$3
+    local runs="escalamiento_runs.txt"
+
+    > "$runs"
+    for i in $(seq 1 $NUM_RUNS); do
+        run_bench "$procs" "$threads" "$window" >> "$runs"
+    done
+    sort -g "$runs" | awk 'BEGIN { n = 0 } NF == 2 { t[n] = $1; s[n] = $2; n++ }
+                                          END { if (n > 0) { m = int((n - 1) / 2); print t[m], s[m] } }'
+    rm -f "$runs"
+}
+
+# Imprime la tabla de un estudio. Cada línea de entrada es
+# "<procesos> <hilos> <ventana> <tiempo> <tasa serial>"; la referencia es la
+# configuración 1x1 si está en la matriz, si no la tasa serial medida por --bench.
+# Fuerte: S = T1 / Tp. Débil (ventana proporcional a p): S = p * T1 / Tp.
+# Karp-Flatt: e = (1/S - 1/p) / (1 - 1/p), fracción serial experimental
+print_table() {
+    local study=$1
+    local data=$2
+
+    awk -v study="$study" '
+        { procs[NR] = $1; threads[NR] = $2; window[NR] = $3; time[NR] = $4; serial[NR] = $5
+          if ($1 == 1 && $2 == 1) ref = NR }
+        END {
+            printf "%-9s | %-6s | %-12s | %-14s | %-12s | %-14s | %-9s | %-14s | %s\n",
+                   "Procesos", "Hilos", "Trabajadores", "Ventana", "Tiempo (s)", "Llaves/s",
+                   "Speedup", "Eficiencia (%)", "Karp-Flatt"
+            print "------------------------------------------------------------------------------------------------------------------------"
+            for (i = 1; i <= NR; i++) {
+                p = procs[i] * threads[i]
+                if (time[i] == "") {
+                    printf "%-9d | %-6d | %-12d | %-14d | %-12s |\n", procs[i], threads[i], p, window[i], "ERROR"
+                    continue
+                }
+                # Tiempo de un trabajador con la ventana de un trabajador
+                base = (study == "fuerte") ? window[i] : window[i] / p
+                t1 = ref ? time[ref] * base / window[ref] : base / serial[i]
+                speedup = (study == "fuerte") ? t1 / time[i] : p * t1 / time[i]
+                kf = (p > 1) ? sprintf("%.4f", (1 / speedup - 1 / p) / (1 - 1 / p)) : "-"
+                printf "%-9d | %-6d | %-12d | %-14d | %-12.6f | %-14.0f | %-9.4f | %-14.2f | %s\n",
+                       procs[i], threads[i], p, window[i], time[i], window[i] / time[i],
+                       speedup, 100 * speedup / p, kf
+            }
+        }' "$data"
+}
+
+echo "Compilando versión paralela..."
+mpicc -O2 -fopenmp -o main_parallel program_parallel.c -lssl -lcrypto
+if [ $? -ne 0 ]; then
+    echo "ERROR: Compilación de versión paralela falló"
+    exit 1
+fi
+
+./main_parallel "$TEST_INPUT" "$TEST_FILE" > /dev/null 2>&1
+if [ ! -f "$TEST_FILE" ]; then
+    echo "ERROR: No se pudo cifrar $TEST_INPUT"
+    exit 1
+fi
+echo "Compilación exitosa"
+echo ""
+
+for STUDY in fuerte debil; do
+    if [ "$STUDY" == "fuerte" ]; then
+        results="$STRONG_FILE"
+        title="ESCALAMIENTO FUERTE: $STRONG_WINDOW llaves en total"
+    else
+        results="$WEAK_FILE"
+        title="ESCALAMIENTO DÉBIL: $WEAK_WINDOW llaves por trabajador"
+    fi
+
+    {
+        echo "========================================================="
+        echo "  $title"
+        echo "========================================================="
+        echo ""
+        echo "Motor:           $ENGINE"
+        echo "Procesos:        $PROCS"
+        echo "Hilos:           $THREADS"
+        echo "Ejecuciones:     $NUM_RUNS por configuración (mediana)"
+        echo ""
+    } | tee -a "$results"
+
+    data="escalamiento_$STUDY.dat"
+    > "$data"
+    for procs in $PROCS; do
+        for threads in $THREADS; do
+            workers=$((procs * threads))
+            if [ "$STUDY" == "fuerte" ]; then
+                window=$STRONG_WINDOW
+            else
+                window=$((WEAK_WINDOW * workers))
+            fi
+
+            printf "  %d procesos x %d hilos, %d llaves... " "$procs" "$threads" "$window"
+            result=$(median_bench "$procs" "$threads" "$window")
+            if [ -n "$result" ]; then
+                echo "$(echo $result | cut -d' ' -f1) s"
+            else
+                echo "ERROR"
+            fi
+            echo "$procs $threads $window $result" >> "$data"
+        done
+    done
+    echo ""
+
+    print_table "$STUDY" "$data" | tee -a "$results"
+    echo "" | tee -a "$results"
+    rm -f "$data"
+done
+
+rm -f "$TEST_FILE"
+
+echo "¡Estudio completado!"
+echo ""
+echo "Escalamiento fuerte: $STRONG_FILE"
+echo "Escalamiento débil:  $WEAK_FILE"
+echo "Filas de --bench:    $RAW_FILE"
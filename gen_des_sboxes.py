@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+Generates des_sboxes.h: gate-level (bitsliced) circuits for the eight DES S-boxes.
+
+Each S-box output is a boolean function of the six S-box inputs. The circuits are
+built as multiplexer trees (Shannon decomposition) over a per-S-box variable order,
+with every intermediate node hash-consed by its truth table so that sub-functions
+shared between the four outputs are only computed once. All 720 variable orders are
+tried and the cheapest circuit is kept.
+
+Usage: python3 gen_des_sboxes.py > des_sboxes.h
+"""
+
+import itertools
+import re
+
+SBOXES = [
+    [[14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7],
+     [0, 15, 7, 4, 14, 2, 13, 1, 10, 6, 12, 11, 9, 5, 3, 8],
+     [4, 1, 14, 8, 13, 6, 2, 11, 15, 12, 9, 7, 3, 10, 5, 0],
+     [15, 12, 8, 2, 4, 9, 1, 7, 5, 11, 3, 14, 10, 0, 6, 13]],
+    [[15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10],
+     [3, 13, 4, 7, 15, 2, 8, 14, 12, 0, 1, 10, 6, 9, 11, 5],
+     [0, 14, 7, 11, 10, 4, 13, 1, 5, 8, 12, 6, 9, 3, 2, 15],
+     [13, 8, 10, 1, 3, 15, 4, 2, 11, 6, 7, 12, 0, 5, 14, 9]],
+    [[10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8],
+     [13, 7, 0, 9, 3, 4, 6, 10, 2, 8, 5, 14, 12, 11, 15, 1],
+     [13, 6, 4, 9, 8, 15, 3, 0, 11, 1, 2, 12, 5, 10, 14, 7],
+     [1, 10, 13, 0, 6, 9, 8, 7, 4, 15, 14, 3, 11, 5, 2, 12]],
+    [[7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15],
+     [13, 8, 11, 5, 6, 15, 0, 3, 4, 7, 2, 12, 1, 10, 14, 9],
+     [10, 6, 9, 0, 12, 11, 7, 13, 15, 1, 3, 14, 5, 2, 8, 4],
+     [3, 15, 0, 6, 10, 1, 13, 8, 9, 4, 5, 11, 12, 7, 2, 14]],
+    [[2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9],
+     [14, 11, 2, 12, 4, 7, 13, 1, 5, 0, 15, 10, 3, 9, 8, 6],
+     [4, 2, 1, 11, 10, 13, 7, 8, 15, 9, 12, 5, 6, 3, 0, 14],
+     [11, 8, 12, 7, 1, 14, 2, 13, 6, 15, 0, 9, 10, 4, 5, 3]],
+    [[12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11],
+     [10, 15, 4, 2, 7, 12, 9, 5, 6, 1, 13, 14, 0, 11, 3, 8],
+     [9, 14, 15, 5, 2, 8, 12, 3, 7, 0, 4, 10, 1, 13, 11, 6],
+     [4, 3, 2, 12, 9, 5, 15, 10, 11, 14, 1, 7, 6, 0, 8, 13]],
+    [[4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1],
+     [13, 0, 11, 7, 4, 9, 1, 10, 14, 3, 5, 12, 2, 15, 8, 6],
+     [1, 4, 11, 13, 12, 3, 7, 14, 10, 15, 6, 8, 0, 5, 9, 2],
+     [6, 11, 13, 8, 1, 4, 10, 7, 9, 5, 0, 15, 14, 2, 3, 12]],
+    [[13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7],
+     [1, 15, 13, 8, 10, 3, 7, 4, 12, 5, 6, 11, 0, 14, 9, 2],
+     [7, 11, 4, 1, 9, 12, 14, 2, 0, 6, 10, 13, 15, 3, 5, 8],
+     [2, 1, 14, 7, 4, 10, 8, 13, 15, 12, 9, 0, 3, 5, 6, 11]],
+]
+
+ALL = (1 << 64) - 1
+# Scalar instruction cost of each gate; SEL lowers to xor/and/xor without vpternlogq.
+COST = {'NOT': 1, 'AND': 1, 'OR': 1, 'XOR': 1, 'ANDN': 1, 'SEL': 3}
+
+
+def var_tt(i):
+    """Truth table of input a<i+1>; input index v has a1 as its most significant bit."""
+    return sum(1 << v for v in range(64) if (v >> (5 - i)) & 1)
+
+
+VARS = [var_tt(i) for i in range(6)]
+
+
+def output_tt(sbox, bit):
+    tt = 0
+    for v in range(64):
+        row = ((v >> 4) & 2) | (v & 1)
+        col = (v >> 1) & 15
+        if (sbox[row][col] >> (3 - bit)) & 1:
+            tt |= 1 << v
+    return tt
+
+
+def cofactor(tt, var, value):
+    """Restricts tt to var=value, returned as a function that ignores var."""
+    shift = 5 - var
+    out = 0
+    for v in range(64):
+        src = (v | (1 << shift)) if value else (v & ~(1 << shift))
+        if (tt >> src) & 1:
+            out |= 1 << v
+    return out
+
+
+class Circuit:
+    def __init__(self):
+        self.nodes = {VARS[i]: 'a%d' % (i + 1) for i in range(6)}
+        self.stmts = []
+        self.cost = 0
+
+    def emit(self, tt, kind, expr):
+        name = 't%d' % len(self.stmts)
+        self.stmts.append((name, kind, expr))
+        self.nodes[tt] = name
+        return tt
+
+    def prune(self, outputs):
+        """Drops gates that no output depends on and renumbers the rest."""
+        live = set(self.nodes[tt] for tt in outputs)
+        for name, kind, expr in reversed(self.stmts):
+            if name in live:
+                live.update(re.findall(r't\d+', expr))
+        kept = [stmt for stmt in self.stmts if stmt[0] in live]
+        rename = dict((stmt[0], 't%d' % i) for i, stmt in enumerate(kept))
+        subst = lambda text: re.sub(r't\d+', lambda m: rename[m.group(0)], text)
+        self.stmts = [(rename[name], kind, subst(expr)) for name, kind, expr in kept]
+        self.outputs = [subst(self.nodes[tt]) for tt in outputs]
+        self.cost = sum(COST[kind] for _, kind, _ in self.stmts)
+
+    def mux(self, s, a, b):
+        """Node for (s ? b : a)."""
+        tt = (s & b) | (~s & a & ALL)
+        if tt in self.nodes:
+            return tt
+        n = self.nodes
+        if a == 0:
+            return self.emit(tt, 'AND', 'BS_AND(%s, %s)' % (n[s], n[b]))
+        if b == 0:
+            if a == ALL:
+                return self.emit(tt, 'NOT', 'BS_NOT(%s)' % n[s])
+            return self.emit(tt, 'ANDN', 'BS_ANDN(%s, %s)' % (n[a], n[s]))
+        if b == ALL:
+            return self.emit(tt, 'OR', 'BS_OR(%s, %s)' % (n[a], n[s]))
+        if a == ALL:
+            inner = s & ~b & ALL
+            if inner not in n:
+                self.emit(inner, 'ANDN', 'BS_ANDN(%s, %s)' % (n[s], n[b]))
+            return self.emit(tt, 'NOT', 'BS_NOT(%s)' % n[inner])
+        if b == a ^ ALL:
+            return self.emit(tt, 'XOR', 'BS_XOR(%s, %s)' % (n[a], n[s]))
+        if (a ^ b) in n:
+            d = (a ^ b) & s
+            if d not in n:
+                self.emit(d, 'AND', 'BS_AND(%s, %s)' % (n[a ^ b], n[s]))
+            return self.emit(tt, 'XOR', 'BS_XOR(%s, %s)' % (n[a], n[d]))
+        return self.emit(tt, 'SEL', 'BS_SEL(%s, %s, %s)' % (n[s], n[a], n[b]))
+
+    def build(self, tt, order):
+        if tt in self.nodes:
+            return tt
+        if tt == 0 or tt == ALL:
+            # Constants only appear as mux children and are folded there.
+            return tt
+        if (tt ^ ALL) in self.nodes:
+            return self.emit(tt, 'NOT', 'BS_NOT(%s)' % self.nodes[tt ^ ALL])
+        var = order[0]
+        f0 = cofactor(tt, var, 0)
+        f1 = cofactor(tt, var, 1)
+        if f0 == f1:
+            return self.build(f0, order[1:])
+        a = self.build(f0, order[1:])
+        b = self.build(f1, order[1:])
+        return self.mux(VARS[var], a, b)
+
+
+def synthesize(sbox):
+    outputs = [output_tt(sbox, bit) for bit in range(4)]
+    best = None
+    for order in itertools.permutations(range(6)):
+        c = Circuit()
+        c.prune([c.build(tt, list(order)) for tt in outputs])
+        if best is None or c.cost < best.cost:
+            best = c
+    return best
+
+
+def main():
+    print('/**')
+    print(' * @file des_sboxes.h')
+    print(' * @brief Bitsliced gate circuits for the eight DES S-boxes')
+    print(' *')
+    print(' * GENERATED by gen_des_sboxes.py - do not edit by hand.')
+    print(' *')
+    print(' * Each DES_SBOXn(a1..a6, o1..o4) macro evaluates S-box n on bitsliced inputs')
+    print(' * a1..a6 (a1 = first E-expansion bit of the group) and XORs the four outputs')
+    print(' * into the lvalues o1..o4 (o1 = most significant S-box output bit). The')
+    print(' * including kernel must define BS_T and the gate macros BS_AND, BS_OR, BS_XOR,')
+    print(' * BS_ANDN(a, b) = a & ~b, BS_NOT and BS_SEL(s, a, b) = s ? b : a.')
+    print(' */')
+    print()
+    print('#ifndef DES_SBOXES_H')
+    print('#define DES_SBOXES_H')
+    for idx, sbox in enumerate(SBOXES):
+        c = synthesize(sbox)
+        print()
+        print('/* S%d: %d gates (%d scalar ops) */' % (idx + 1, len(c.stmts), c.cost))
+        print('#define DES_SBOX%d(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4) do { \\' % (idx + 1))
+        for name, kind, expr in c.stmts:
+            print('    BS_T %s = %s; \\' % (name, expr))
+        for bit, name in enumerate(c.outputs):
+            print('    o%d = BS_XOR(o%d, %s); \\' % (bit + 1, bit + 1, name))
+        print('} while(0)')
+    print()
+    print('#endif /* DES_SBOXES_H */')
+
+
+if __name__ == '__main__':
+    main()
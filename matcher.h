@@ -0,0 +1,209 @@
+/**
+ * @file matcher.h
+ * @brief Length-bounded substring matcher with SIMD first/last-byte filtering
+ *
+ * Replaces strstr for checking decrypted text. A Matcher is built once per
+ * search string and then searches a buffer of known length, so NUL bytes
+ * produced by wrong keys do not cut the search short: the whole plaintext
+ * is always searched, whatever the key.
+ *
+ * On x86-64 candidate positions are found 16 (SSE2) or 32 (AVX2) at a time
+ * by comparing the first and the last byte of the needle against two
+ * shifted loads of the haystack; only positions where both match are
+ * verified with memcmp. The AVX2 version is picked at runtime when the CPU
+ * supports it.
+ *
+ * A matcher can also wrap an Aho-Corasick automaton to look for several
+ * patterns at once, requiring any or all of them (see matcherInitMulti).
+ */
+
+#ifndef MATCHER_H
+#define MATCHER_H
+
+#include <string.h>
+#include "aho_corasick.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define MATCHER_HAVE_X86 1
+#endif
+
+typedef struct Matcher Matcher;
+
+/** Returns the offset of the first occurrence of the needle in hay[0..n), or -1 */
+typedef int (*MatcherFindFn)(const Matcher *m, const unsigned char *hay, int n);
+
+/**
+ * @brief Search string prepared for repeated searches
+ */
+struct Matcher {
+    const unsigned char *needle; /**< Search string (not copied, must outlive the matcher) */
+    int len;                     /**< Length of the search string */
+    MatcherFindFn find;          /**< Implementation selected for this CPU */
+    const char *name;            /**< Name of the implementation */
+    const AcAutomaton *ac;       /**< Multi-pattern automaton, or NULL */
+    uint64_t need;               /**< Patterns required by a multi-pattern match, 0 for any */
+};
+
+/**
+ * @brief Portable fallback: memchr on the first byte, then memcmp
+ */
+static int matcherFindScalar(const Matcher *m, const unsigned char *hay, int n){
+    if(m->len == 0){
+        return 0;
+    }
+    // Checked before forming last, which would point before hay
+    if(n < m->len){
+        return -1;
+    }
+    const unsigned char *p = hay;
+    const unsigned char *last = hay + n - m->len;
+    while(p <= last){
+        p = (const unsigned char *)memchr(p, m->needle[0], last - p + 1);
+        if(!p){
+            return -1;
+        }
+        if(memcmp(p + 1, m->needle + 1, m->len - 1) == 0){
+            return (int)(p - hay);
+        }
+        p++;
+    }
+    return -1;
+}
+
+#ifdef MATCHER_HAVE_X86
+
+/**
+ * @brief Checks the candidate positions of a first/last-byte mask
+ *
+ * @return Offset of the first verified match relative to pos, or -1
+ */
+static inline int matcherVerify(const Matcher *m, const unsigned char *pos, unsigned mask){
+    while(mask){
+        int bit = __builtin_ctz(mask);
+        if(memcmp(pos + bit + 1, m->needle + 1, m->len - 2) == 0){
+            return bit;
+        }
+        mask &= mask - 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief SSE2 first/last-byte filter, 16 positions per step
+ */
+static int matcherFindSse2(const Matcher *m, const unsigned char *hay, int n){
+    if(m->len < 2 || n < m->len){
+        return matcherFindScalar(m, hay, n);
+    }
+    const __m128i first = _mm_set1_epi8((char)m->needle[0]);
+    const __m128i last = _mm_set1_epi8((char)m->needle[m->len - 1]);
+    int i = 0;
+
+    // Both loads must stay inside the buffer
+    for(; i + m->len - 1 + 16 <= n; i += 16){
+        __m128i a = _mm_loadu_si128((const __m128i *)(hay + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(hay + i + m->len - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        int hit = matcherVerify(m, hay + i, mask);
+        if(hit >= 0){
+            return i + hit;
+        }
+    }
+
+    int hit = matcherFindScalar(m, hay + i, n - i);
+    return (hit >= 0) ? i + hit : -1;
+}
+
+/**
+ * @brief AVX2 first/last-byte filter, 32 positions per step
+ */
+__attribute__((target("avx2")))
+static int matcherFindAvx2(const Matcher *m, const unsigned char *hay, int n){
+    if(m->len < 2 || n < m->len){
+        return matcherFindScalar(m, hay, n);
+    }
+    const __m256i first = _mm256_set1_epi8((char)m->needle[0]);
+    const __m256i last = _mm256_set1_epi8((char)m->needle[m->len - 1]);
+    int i = 0;
+
+    // Both loads must stay inside the buffer
+    for(; i + m->len - 1 + 32 <= n; i += 32){
+        __m256i a = _mm256_loadu_si256((const __m256i *)(hay + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(hay + i + m->len - 1));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                                                               _mm256_cmpeq_epi8(b, last)));
+        int hit = matcherVerify(m, hay + i, mask);
+        if(hit >= 0){
+            return i + hit;
+        }
+    }
+
+    int hit = matcherFindSse2(m, hay + i, n - i);
+    return (hit >= 0) ? i + hit : -1;
+}
+
+#endif /* MATCHER_HAVE_X86 */
+
+/**
+ * @brief Multi-pattern search through the Aho-Corasick automaton
+ */
+static inline int matcherFindAc(const Matcher *m, const unsigned char *hay, int n){
+    return acScan(m->ac, hay, n, m->need);
+}
+
+/**
+ * @brief Prepares a matcher for a search string
+ *
+ * @param m Matcher to initialize
+ * @param needle Search string (must outlive the matcher)
+ * @param len Length of the search string
+ */
+static void matcherInit(Matcher *m, const char *needle, int len){
+    m->needle = (const unsigned char *)needle;
+    m->len = len;
+    m->find = matcherFindScalar;
+    m->name = "scalar";
+    m->ac = NULL;
+    m->need = 0;
+#ifdef MATCHER_HAVE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        m->find = matcherFindAvx2;
+        m->name = "avx2";
+    } else {
+        m->find = matcherFindSse2;
+        m->name = "sse2";
+    }
+#endif
+}
+
+/**
+ * @brief Prepares a matcher for a set of patterns
+ *
+ * @param m Matcher to initialize
+ * @param ac Compiled patterns (must outlive the matcher)
+ * @param all Nonzero if every pattern must occur (AND), zero if any one suffices (OR)
+ */
+static inline void matcherInitMulti(Matcher *m, const AcAutomaton *ac, int all){
+    m->needle = NULL;
+    m->len = 0;
+    m->find = matcherFindAc;
+    m->name = all ? "aho-corasick (all)" : "aho-corasick (any)";
+    m->ac = ac;
+    m->need = all ? ac->all : 0;
+}
+
+/**
+ * @brief Tests whether a buffer contains the search string
+ *
+ * @param m Matcher built by matcherInit
+ * @param hay Buffer to search (NUL bytes are ordinary characters)
+ * @param n Length of the buffer
+ * @return 1 if the search string occurs in hay[0..n), 0 otherwise
+ */
+static inline int matcherContains(const Matcher *m, const unsigned char *hay, int n){
+    return m->find(m, hay, n) >= 0;
+}
+
+#endif /* MATCHER_H */
@@ -0,0 +1,138 @@
+/**
+ * @file perf_counters.h
+ * @brief Per-thread hardware performance counters with perf_event_open
+ *
+ * Each searching thread opens its own counters (pid 0, cpu -1: the calling
+ * thread on whatever CPU it runs) for user-space cycles, instructions, L1D
+ * read misses and branch misses, plus the task clock. The task clock is a
+ * software counter, so it works even where the PMU is not exposed, as in
+ * many VMs and containers.
+ *
+ * Counters are started and paused around the work to measure only, so
+ * barriers and MPI waits in between do not add to the counts.
+ *
+ * Counters are opened one by one rather than as a group, so an event the
+ * kernel refuses only marks that counter unavailable. When the kernel
+ * multiplexes them, counts are scaled by time enabled over time running.
+ *
+ * Linux only; counting only user space works with perf_event_paranoid <= 2.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/** Counted events */
+enum { PERF_TASK_CLOCK, PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_BRANCH_MISSES, PERF_NCOUNTERS };
+
+/** Names of the events, as printed */
+static const char *const perf_names[PERF_NCOUNTERS] = {
+    "task-clock (ns)", "cycles", "instructions", "L1D misses", "branch misses"
+};
+
+/**
+ * @brief Counters of one thread
+ */
+typedef struct {
+    int fd[PERF_NCOUNTERS]; /**< Event file descriptors, -1 if unavailable */
+    int error;              /**< errno of the first event that could not be opened, 0 if none */
+} PerfCounters;
+
+/**
+ * @brief Opens the counters of the calling thread, stopped at zero
+ *
+ * @return Number of counters available
+ */
+static inline int perfOpen(PerfCounters *pc){
+    static const struct { unsigned type; unsigned long long config; } events[PERF_NCOUNTERS] = {
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    int n = 0;
+    pc->error = 0;
+    for(int c = 0; c < PERF_NCOUNTERS; c++){
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[c].type;
+        attr.config = events[c].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        pc->fd[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if(pc->fd[c] < 0){
+            if(pc->error == 0) pc->error = errno;
+        } else {
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Starts or resumes the counters, keeping their counts
+ */
+static inline void perfStart(PerfCounters *pc){
+    for(int c = 0; c < PERF_NCOUNTERS; c++){
+        if(pc->fd[c] >= 0){
+            ioctl(pc->fd[c], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+/**
+ * @brief Pauses the counters until the next perfStart
+ */
+static inline void perfPause(PerfCounters *pc){
+    for(int c = 0; c < PERF_NCOUNTERS; c++){
+        if(pc->fd[c] >= 0){
+            ioctl(pc->fd[c], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+/**
+ * @brief Stops the counters and reads them
+ *
+ * @param pc Counters
+ * @param values Array to store the count of each event, scaled for
+ *               multiplexing, or -1 if the event is unavailable
+ */
+static inline void perfStop(PerfCounters *pc, double values[PERF_NCOUNTERS]){
+    for(int c = 0; c < PERF_NCOUNTERS; c++){
+        unsigned long long data[3]; // value, time enabled, time running
+        values[c] = -1;
+        if(pc->fd[c] < 0){
+            continue;
+        }
+        ioctl(pc->fd[c], PERF_EVENT_IOC_DISABLE, 0);
+        if(read(pc->fd[c], data, sizeof(data)) == (ssize_t)sizeof(data)){
+            values[c] = (data[2] > 0) ? (double)data[0] * data[1] / data[2] : 0;
+        }
+    }
+}
+
+/**
+ * @brief Closes the counters
+ */
+static inline void perfClose(PerfCounters *pc){
+    for(int c = 0; c < PERF_NCOUNTERS; c++){
+        if(pc->fd[c] >= 0){
+            close(pc->fd[c]);
+            pc->fd[c] = -1;
+        }
+    }
+}
+
+#endif /* PERF_COUNTERS_H */
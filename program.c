@@ -15,6 +15,14 @@
 #include <mpi.h>
 #include <openssl/des.h>
 #include <time.h>
+#include "matcher.h"
+#include "chunk_sched.h"
+#include "termination.h"
+#include "results.h"
+#include "workload.h"
+
+/** Default keys per chunk of the dynamic scheduler */
+#define SCHED_DEFAULT_CHUNK (1L << 24)
 
 /**
  * @brief Decrypts ciphertext using DES algorithm (OpenSSL implementation)
@@ -96,14 +104,13 @@ void encrypt(long key, unsigned char *plain, int len, unsigned char *output){
  * @param key Candidate DES key to test
  * @param ciph Ciphertext to decrypt
  * @param len Length of the ciphertext
- * @param search Search string to look for in decrypted text
+ * @param matcher Matcher for the search string
  * @return 1 if the decrypted text contains the search pattern, 0 otherwise
  */
-int tryKey(long key, unsigned char *ciph, int len, char *search){
-    unsigned char temp[len+1];
+int tryKey(long key, unsigned char *ciph, int len, const Matcher *matcher){
+    unsigned char temp[len];
     decrypt(key, ciph, len, temp);
-    temp[len] = 0;
-    return strstr((char *)temp, search) != NULL;
+    return matcherContains(matcher, temp, len);
 }
 
 /**
@@ -222,6 +229,47 @@ int isBinaryFile(const char *filename){
     return (len > 4 && strcmp(filename + len - 4, ".bin") == 0);
 }
 
+/**
+ * @brief Parses the options following <encrypted.bin> <search_string>
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param chunk Pointer to store the keys per dynamic chunk, or 0 for static ranges
+ * @param results Pointer to store the file for the result record, or NULL
+ * @param verbose Nonzero to print the reason of a failure
+ * @return 1 on success, 0 on an unknown or malformed option
+ */
+int parseScheduleOptions(int argc, char *argv[], long *chunk, const char **results, int verbose){
+    *chunk = 0;
+    *results = NULL;
+    for(int i = 3; i < argc; i++){
+        if(strcmp(argv[i], "--schedule") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "static") == 0){
+                *chunk = 0;
+            } else if(strcmp(argv[i], "dynamic") == 0){
+                if(*chunk == 0) *chunk = SCHED_DEFAULT_CHUNK;
+            } else {
+                if(verbose) printf("Error: Unknown schedule %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--chunk") == 0 && i + 1 < argc){
+            char *end;
+            *chunk = strtol(argv[++i], &end, 10);
+            if(*end != 0 || *chunk <= 0){
+                if(verbose) printf("Error: Invalid chunk size %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--results") == 0 && i + 1 < argc){
+            *results = argv[++i];
+        } else {
+            if(verbose) printf("Error: Unknown option %s\n", argv[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
 /**
  * @brief Main entry point for DES encryption/brute-force program
  *
@@ -235,34 +283,45 @@ int isBinaryFile(const char *filename){
  * @param argc Argument count
  * @param argv Argument vector
  *   Encryption mode: program <input.txt>
- *   Brute-force mode: program <encrypted.bin> <search_string>
+ *   Brute-force mode: program <encrypted.bin> <search_string> [--schedule static|dynamic] [--chunk n]
  * @return 0 on success, 1 on error
  */
 int main(int argc, char *argv[]){
     int N, id;
     long upper = (1L << 56); // Upper bound for DES keys: 2^56
     long mylower, myupper;
-    MPI_Status st;
-    MPI_Request req;
     int ciphlen;
+    long chunk = 0;
+    const char *results = NULL;
     MPI_Comm comm = MPI_COMM_WORLD;
 
     MPI_Init(&argc, &argv);
     MPI_Comm_size(comm, &N);
     MPI_Comm_rank(comm, &id);
+    PhaseTimer timer;
+    phaseInit(&timer);
 
     if(argc < 2){
         if(id == 0){
             printf("Usage:\n");
             printf("  MODE 1 (Encrypt from .txt):\n");
-            printf("    mpirun -np <N> %s <input.txt>\n", argv[0]);
+            printf("    mpirun -np <N> %s <input.txt> [options]\n", argv[0]);
             printf("    Input file format:\n");
             printf("      Line 1: Encryption key (integer)\n");
             printf("      Line 2: Text to encrypt\n");
             printf("      Line 3: Substring to search for\n");
+            printf("      --rank <r>                 Replace the key with one in the range of process r\n");
+            printf("      --at <f>                   at fraction f of it: 0 = first key searched, 1 = last\n");
+            printf("      --ranks <N>                Ranges of a split among N processes (default: -np)\n");
             printf("\n");
             printf("  MODE 2 (Decrypt from .bin):\n");
-            printf("    mpirun -np <N> %s <encrypted.bin> <search_string>\n", argv[0]);
+            printf("    mpirun -np <N> %s <encrypted.bin> <search_string> [options]\n", argv[0]);
+            printf("      --schedule static|dynamic  static: fixed range per process (default);\n");
+            printf("                                 dynamic: rank 0 hands out chunks on request\n");
+            printf("      --chunk <n>                Keys per dynamic chunk (implies dynamic,\n");
+            printf("                                 default: %ld)\n", SCHED_DEFAULT_CHUNK);
+            printf("      --results <file>           Append a result record with per-phase times;\n");
+            printf("                                 JSON Lines if <file> ends in .json, else CSV\n");
             printf("    Example: mpirun -np 4 %s message.bin \"secret message\"\n", argv[0]);
         }
         MPI_Finalize();
@@ -277,6 +336,20 @@ int main(int argc, char *argv[]){
 
     // Only rank 0 reads file and encrypts (encryption mode)
     if(!is_binary_mode){
+        // Synthetic workload: the key goes at a chosen point of a rank's range
+        WorkloadSpec workload;
+        if(!workloadParse(argc, argv, 2, N, &workload, id == 0)){
+            MPI_Finalize();
+            return 1;
+        }
+        if(workload.rank == WORKLOAD_ALL_RANKS || workload.nfractions > 1){
+            if(id == 0){
+                printf("Error: Only one key can be placed (use program_parallel to generate several)\n");
+            }
+            MPI_Finalize();
+            return 1;
+        }
+
         if(id == 0){
             printf("=== MODE 1: DES Brute Force Cracker ===\n");
             printf("Reading input from: %s\n\n", argv[1]);
@@ -284,6 +357,11 @@ int main(int argc, char *argv[]){
             if(!readInputFile(argv[1], &encryption_key, &plaintext, &ciphlen, &search)){
                 MPI_Abort(comm, 1);
             }
+            if(workload.nfractions > 0){
+                encryption_key = workloadKey(upper, workload.ranks, workload.rank, workload.fractions[0]);
+                printf("Key placed at %g of the range of process %d of %d\n",
+                       workload.fractions[0], workload.rank, workload.ranks);
+            }
             
             printf("--- Input Parameters ---\n");
             printf("Encryption key: %ld\n", encryption_key);
@@ -333,7 +411,12 @@ int main(int argc, char *argv[]){
             MPI_Finalize();
             return 1;
         }
-    
+
+        if(!parseScheduleOptions(argc, argv, &chunk, &results, id == 0)){
+            MPI_Finalize();
+            return 1;
+        }
+
         if(id == 0){
             printf("=== MODE 2: Decrypt from Binary ===\n");
             printf("Encrypted file: %s\n", argv[1]);
@@ -353,6 +436,10 @@ int main(int argc, char *argv[]){
         }
     }
 
+    // Waiting for rank 0 to read the file counts as setup, not as broadcast
+    MPI_Barrier(comm);
+    phaseEnd(&timer, PHASE_SETUP);
+
     // Broadcast ciphertext length to all processes
     MPI_Bcast(&ciphlen, 1, MPI_INT, 0, comm);
 
@@ -364,11 +451,15 @@ int main(int argc, char *argv[]){
     // Broadcast ciphertext and search string to all processes
     MPI_Bcast(cipher, ciphlen, MPI_UNSIGNED_CHAR, 0, comm);
     MPI_Bcast(search, 256, MPI_CHAR, 0, comm);
+    phaseEnd(&timer, PHASE_BCAST);
+
+    Matcher matcher;
+    matcherInit(&matcher, search, strlen(search));
 
     // Divide keyspace among MPI processes
     long range_per_node = upper / N;
     mylower = range_per_node * id;
-    myupper = range_per_node * (id+1) - 1;
+    myupper = range_per_node * (id+1);
     if(id == N-1){
         // Last process handles remainder
         myupper = upper;
@@ -378,78 +469,127 @@ int main(int argc, char *argv[]){
         printf("--- Brute Force Search ---\n");
         printf("Total processes: %d\n", N);
         printf("Search space: 2^56 = %ld keys\n", upper);
-        printf("Keys per process: ~%ld\n", range_per_node);
+        if(chunk > 0){
+            printf("Dynamic schedule: chunks of %ld keys handed out by rank 0\n", chunk);
+        } else {
+            printf("Keys per process: ~%ld\n", range_per_node);
+        }
         printf("Starting search...\n\n");
     }
     
-    printf("[Process %d] Searching range: %ld to %ld\n", id, mylower, myupper);
+    if(chunk > 0){
+        printf("[Process %d] Searching dynamic chunks\n", id);
+    } else {
+        printf("[Process %d] Searching range: %ld to %ld\n", id, mylower, myupper - 1);
+    }
 
     long found = 0;
-    // Set up non-blocking receive to detect when another process finds the key
-    MPI_Irecv(&found, 1, MPI_LONG, MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &req);
+    // One-sided stop signal: the finder publishes TERM_KEY(key) in rank 0's result slot
+    Termination term;
+    termInit(&term, comm);
+
+    ChunkScheduler sched;
+    schedInit(&sched, comm, mylower, (chunk > 0) ? upper : myupper, chunk, NULL);
+    long chunk_lower, chunk_upper;
 
-    time_t start_time = time(NULL);
     long keys_tested = 0;
-    int flag = 0;
+    phaseEnd(&timer, PHASE_SETUP);
+    double search_start = timer.last;
 
-    // Search assigned keyspace range
+    // Search the assigned ranges: the whole process range, or chunks from rank 0
     // Check if another process found the key (check every 10000 keys to reduce overhead)
-    for(long i = mylower; i < myupper; ++i){
-        if(keys_tested % 10000 == 0){
-            MPI_Test(&req, &flag, &st);
-            if(flag && found != 0){
-                printf("[Process %d] Received termination signal. Key found by another process: %ld\n", id, found);
-                break;
+    while(found == 0 && schedNext(&sched, &chunk_lower, &chunk_upper, &term)){
+        for(long i = chunk_lower; i < chunk_upper; ++i){
+            if(keys_tested % 10000 == 0){
+                if(id == 0){
+                    schedServe(&sched);
+                }
+                found = termPoll(&term);
+                if(found != 0){
+                    printf("[Process %d] Received termination signal. Key found by another process: %ld\n",
+                           id, TERM_KEY_OF(found));
+                    break;
+                }
             }
-        }
 
-        // Try current key
-        if(tryKey(i, cipher, ciphlen, search)){
-            found = i;
-            printf("[Process %d] KEY FOUND: %ld\n", id, found);
-            // Notify all processes that key was found
-            for(int node=0; node<N; node++){
-                MPI_Send(&found, 1, MPI_LONG, node, 0, comm);
+            // Try current key
+            if(tryKey(i, cipher, ciphlen, &matcher)){
+                printf("[Process %d] KEY FOUND: %ld\n", id, i);
+                // Notify all processes; if several found candidates, the first one wins
+                found = termSignal(&term, TERM_KEY(i));
+                break;
             }
-            break;
-        }
-        keys_tested++;
-
-        // Print progress updates periodically
-        if(keys_tested % 1000000 == 0){
-            double elapsed = difftime(time(NULL), start_time);
-            if(elapsed > 0){
-                printf("[Process %d] Progress: %ld keys tested (%.2f keys/sec)\n",
-                       id, keys_tested, keys_tested/elapsed);
+            keys_tested++;
+
+            // Print progress updates periodically
+            if(keys_tested % 1000000 == 0){
+                double elapsed = MPI_Wtime() - search_start;
+                if(elapsed > 0){
+                    printf("[Process %d] Progress: %ld keys tested (%.2f keys/sec)\n",
+                           id, keys_tested, keys_tested/elapsed);
+                }
             }
         }
     }
-    
-    if(!flag){
-        MPI_Cancel(&req);
-        MPI_Wait(&req, &st);
-    }
+    phaseEnd(&timer, PHASE_SEARCH);
+
+    double stop_latency;
+    found = termFinish(&term, &stop_latency);
+    // Every rank has stopped: no chunk request can be sent anymore
+    schedFinish(&sched);
+    long key = (found > 0) ? TERM_KEY_OF(found) : -1;
+    phaseEnd(&timer, PHASE_STOP);
+    unsigned char decrypted[ciphlen + 1];
+    decrypted[0] = 0;
     
     if(id == 0){
-        if(!flag){
-            MPI_Wait(&req, &st);
-        }
-        time_t end_time = time(NULL);
-        
         printf("\n=== Results ===\n");
         if(found > 0){
-            unsigned char decrypted[ciphlen+1];
-            decrypt(found, cipher, ciphlen, decrypted);
+            decrypt(key, cipher, ciphlen, decrypted);
             decrypted[ciphlen] = 0;
             
             printf("SUCCESS!\n");
-            printf("Key found: %ld\n", found);
+            printf("Key found: %ld\n", key);
             printf("Decrypted text: %s\n", decrypted);
-            printf("Time elapsed: %.2f seconds\n", difftime(end_time, start_time));
+            printf("Time elapsed: %.6f seconds\n", timer.phase[PHASE_SEARCH] + timer.phase[PHASE_STOP]);
+            printf("Stop latency: %.3f ms (until the last process stopped)\n", 1e3 * stop_latency);
         } else {
             printf("FAILED - Key not found in search space\n");
         }
     }
+    phaseEnd(&timer, PHASE_VERIFY);
+
+    RunResult result;
+    long total_tested;
+    phaseReduce(&timer, result.phase, comm);
+    MPI_Reduce(&keys_tested, &total_tested, 1, MPI_LONG, MPI_SUM, 0, comm);
+    if(id == 0){
+        printf("Phases (slowest process): setup %.6f s, broadcast %.6f s, search %.6f s, "
+               "stop %.6f s, verify %.6f s\n",
+               result.phase[PHASE_SETUP], result.phase[PHASE_BCAST], result.phase[PHASE_SEARCH],
+               result.phase[PHASE_STOP], result.phase[PHASE_VERIFY]);
+
+        if(results){
+            result.program = "program";
+            result.input = argv[1];
+            result.search = search;
+            result.processes = N;
+            result.threads = 1;
+            result.engine = "openssl";
+            result.schedule = (chunk > 0) ? "dynamic" : "static";
+            result.chunk = chunk;
+            result.keyspace = upper;
+            result.status = (found > 0) ? "found" : "not_found";
+            result.key = key;
+            result.plaintext = (const char *)decrypted;
+            result.keys_tested = total_tested;
+            result.total = MPI_Wtime() - timer.start;
+            result.stop_latency = stop_latency;
+            if(!resultsWrite(results, &result)){
+                printf("Warning: Cannot write results to %s\n", results);
+            }
+        }
+    }
     
     free(cipher);
     if(id == 0 && plaintext) free(plaintext);
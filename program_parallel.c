@@ -10,6 +10,7 @@
  * to achieve maximum performance when searching the DES keyspace (2^56 keys).
  */
 
+#define _GNU_SOURCE // sched_setaffinity (topology.h)
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,21 +18,35 @@
 #include <omp.h>
 #include <openssl/des.h>
 #include <time.h>
+#include <stdint.h>
+#include <signal.h>
+#include "des_bitslice.h"
+#include "des_sp.h"
+#include "matcher.h"
+#include "chunk_sched.h"
+#include "checkpoint.h"
+#include "termination.h"
+#include "topology.h"
+#include "results.h"
+#include "progress.h"
+#include "workload.h"
+#include "perf_counters.h"
+#include "trace.h"
+
+/** All 56 search key bits set: XOR with it gives the complementary key */
+#define KEY_MASK ((1L << 56) - 1)
 
 /**
- * @brief Decrypts ciphertext using DES algorithm (OpenSSL implementation)
+ * @brief Builds the OpenSSL key schedule for a 56-bit key
  *
- * Converts a 56-bit key to a 64-bit DES key with parity bits and performs
- * DES decryption in ECB mode using OpenSSL's DES functions.
+ * Converts a 56-bit key to a 64-bit DES key with parity bits and expands
+ * it into the 16 round subkeys.
  *
  * @param key 56-bit DES key (without parity bits)
- * @param ciph Pointer to ciphertext buffer
- * @param len Length of the ciphertext (must be multiple of 8)
- * @param output Pointer to output buffer for decrypted data
+ * @param schedule Pointer to store the key schedule
  */
-void decrypt(long key, unsigned char *ciph, int len, unsigned char *output){
+void setKeySchedule(long key, DES_key_schedule *schedule){
     DES_cblock keyBlock;
-    DES_key_schedule schedule;
 
     // Convert 56-bit key to 64-bit DES key with parity
     long k = 0;
@@ -43,17 +58,44 @@ void decrypt(long key, unsigned char *ciph, int len, unsigned char *output){
     // Copy key to DES_cblock and set parity
     memcpy(&keyBlock, &k, 8);
     DES_set_odd_parity(&keyBlock);
-    DES_set_key_unchecked(&keyBlock, &schedule);
+    DES_set_key_unchecked(&keyBlock, schedule);
+}
 
+/**
+ * @brief Decrypts ciphertext with an already expanded key schedule
+ *
+ * @param schedule Key schedule (see setKeySchedule)
+ * @param ciph Pointer to ciphertext buffer
+ * @param len Length of the ciphertext (must be multiple of 8)
+ * @param output Pointer to output buffer for decrypted data
+ */
+void decryptWithSchedule(DES_key_schedule *schedule, unsigned char *ciph, int len, unsigned char *output){
     // Decrypt data in 8-byte blocks
     for(int i=0; i<len; i+=8){
         DES_ecb_encrypt((DES_cblock *)(ciph + i),
                        (DES_cblock *)(output + i),
-                       &schedule,
+                       schedule,
                        DES_DECRYPT);
     }
 }
 
+/**
+ * @brief Decrypts ciphertext using DES algorithm (OpenSSL implementation)
+ *
+ * Converts a 56-bit key to a 64-bit DES key with parity bits and performs
+ * DES decryption in ECB mode using OpenSSL's DES functions.
+ *
+ * @param key 56-bit DES key (without parity bits)
+ * @param ciph Pointer to ciphertext buffer
+ * @param len Length of the ciphertext (must be multiple of 8)
+ * @param output Pointer to output buffer for decrypted data
+ */
+void decrypt(long key, unsigned char *ciph, int len, unsigned char *output){
+    DES_key_schedule schedule;
+    setKeySchedule(key, &schedule);
+    decryptWithSchedule(&schedule, ciph, len, output);
+}
+
 /**
  * @brief Encrypts plaintext using DES algorithm (OpenSSL implementation)
  *
@@ -66,19 +108,8 @@ void decrypt(long key, unsigned char *ciph, int len, unsigned char *output){
  * @param output Pointer to output buffer for encrypted data
  */
 void encrypt(long key, unsigned char *plain, int len, unsigned char *output){
-    DES_cblock keyBlock;
     DES_key_schedule schedule;
-
-    // Convert 56-bit key to 64-bit DES key with parity
-    long k = 0;
-    for(int i=0; i<8; ++i){
-        key <<= 1;
-        k += (key & (0xFEL << i*8));
-    }
-
-    memcpy(&keyBlock, &k, 8);
-    DES_set_odd_parity(&keyBlock);
-    DES_set_key_unchecked(&keyBlock, &schedule);
+    setKeySchedule(key, &schedule);
 
     // Encrypt data in 8-byte blocks
     for(int i=0; i<len; i+=8){
@@ -98,14 +129,338 @@ void encrypt(long key, unsigned char *plain, int len, unsigned char *output){
  * @param key Candidate DES key to test
  * @param ciph Ciphertext to decrypt
  * @param len Length of the ciphertext
- * @param search Search string to look for in decrypted text
+ * @param matcher Matcher for the search string
  * @return 1 if the decrypted text contains the search pattern, 0 otherwise
  */
-int tryKey(long key, unsigned char *ciph, int len, char *search){
-    unsigned char temp[len+1];
+int tryKey(long key, unsigned char *ciph, int len, const Matcher *matcher){
+    unsigned char temp[len];
     decrypt(key, ciph, len, temp);
-    temp[len] = 0;
-    return strstr((char *)temp, search) != NULL;
+    return matcherContains(matcher, temp, len);
+}
+
+/**
+ * @brief Describes the plaintext a candidate key must produce to be reported
+ */
+typedef struct {
+    unsigned char *cipher; /**< Ciphertext to decrypt */
+    int ciphlen;           /**< Length of the ciphertext */
+    char *search;          /**< Search string to look for in decrypted text */
+    int search_len;        /**< Length of the search string */
+    int offset;            /**< Known byte offset of the search string, or -1 */
+    int partial;           /**< Nonzero to decrypt only the blocks that can decide a match */
+    int known_block;       /**< Byte offset of a block with known plaintext, or -1 */
+    DES_cblock known_plain; /**< Plaintext of the known block */
+    int complement;        /**< Nonzero to also test the complement of every key */
+    Matcher matcher;       /**< Matcher for the search string */
+} SearchTarget;
+
+/** Key schedule of KEY_MASK, XORed in to get the schedule of a complementary key */
+DES_key_schedule key_complement_delta;
+
+/**
+ * @brief Tests a key schedule decrypting only the blocks needed to decide a match
+ *
+ * ECB blocks decrypt independently, so with a known offset only the blocks
+ * covering the search string are decrypted, one at a time, and the first
+ * mismatching byte rejects the key. Surviving candidates are confirmed
+ * with a full decryption.
+ *
+ * @param t Search target (offset must be set)
+ * @param schedule Key schedule of the candidate key
+ * @return 1 if the decrypted text contains the search pattern, 0 otherwise
+ */
+int trySchedulePartial(const SearchTarget *t, DES_key_schedule *schedule){
+    int len = t->ciphlen;
+    int end = t->offset + t->search_len;
+    unsigned char temp[len+8];
+
+    for(int b = t->offset / 8; 8*b < end; b++){
+        DES_ecb_encrypt((DES_cblock *)(t->cipher + 8*b), (DES_cblock *)(temp + 8*b),
+                        schedule, DES_DECRYPT);
+        int from = (8*b > t->offset) ? 8*b : t->offset;
+        int to = (8*b + 8 < end) ? 8*b + 8 : end;
+        if(memcmp(temp + from, t->search + (from - t->offset), to - from) != 0){
+            return 0;
+        }
+    }
+
+    // Survivor: confirm against the whole plaintext
+    decryptWithSchedule(schedule, t->cipher, len, temp);
+    return matcherContains(&t->matcher, temp, len);
+}
+
+/**
+ * @brief Confirms a known-block candidate against the full plaintext
+ *
+ * @param t Search target
+ * @param schedule Key schedule of the candidate key
+ * @return 1 if the decrypted text contains the search pattern, 0 otherwise
+ */
+int confirmSchedule(const SearchTarget *t, DES_key_schedule *schedule){
+    unsigned char temp[t->ciphlen];
+    decryptWithSchedule(schedule, t->cipher, t->ciphlen, temp);
+    return matcherContains(&t->matcher, temp, t->ciphlen);
+}
+
+/**
+ * @brief Tests a key schedule by encrypting the known plaintext block
+ *
+ * When a whole plaintext block is known, a candidate key only has to map it
+ * to the ciphertext block at the same offset: one block encryption and a
+ * 64-bit compare, with no buffer and no string search. The rare survivors
+ * are confirmed against the full plaintext.
+ *
+ * In complement mode the same schedule also tests the complementary key:
+ * DES satisfies E(~k, ~p) = ~E(k, p), so ~k maps the known plaintext p to
+ * the ciphertext c exactly when k maps ~p to ~c.
+ *
+ * @param t Search target (known_block must be set)
+ * @param schedule Key schedule of the candidate key
+ * @return 1 if the key matches, 2 if its complement matches, 0 otherwise
+ */
+int tryScheduleKnownBlock(const SearchTarget *t, DES_key_schedule *schedule){
+    DES_cblock in, out;
+    uint64_t got, expect;
+
+    memcpy(&expect, t->cipher + t->known_block, 8);
+    DES_ecb_encrypt((DES_cblock *)&t->known_plain, &out, schedule, DES_ENCRYPT);
+    memcpy(&got, out, 8);
+    if(got == expect && confirmSchedule(t, schedule)){
+        return 1;
+    }
+    if(!t->complement){
+        return 0;
+    }
+
+    uint64_t plain;
+    memcpy(&plain, t->known_plain, 8);
+    plain = ~plain;
+    memcpy(in, &plain, 8);
+    DES_ecb_encrypt(&in, &out, schedule, DES_ENCRYPT);
+    memcpy(&got, out, 8);
+    if(got != ~expect){
+        return 0;
+    }
+
+    DES_key_schedule inverse = *schedule;
+    for(int r = 0; r < 16; r++){
+        inverse.ks[r].deslong[0] ^= key_complement_delta.ks[r].deslong[0];
+        inverse.ks[r].deslong[1] ^= key_complement_delta.ks[r].deslong[1];
+    }
+    return confirmSchedule(t, &inverse) ? 2 : 0;
+}
+
+/**
+ * @brief Tests a key schedule against the search target
+ *
+ * @param t Search target
+ * @param schedule Key schedule of the candidate key
+ * @return 1 if the decrypted text contains the search pattern, 2 if the
+ *         complementary key's does (complement mode only), 0 otherwise
+ */
+int trySchedule(const SearchTarget *t, DES_key_schedule *schedule){
+    if(t->known_block >= 0){
+        return tryScheduleKnownBlock(t, schedule);
+    }
+    if(t->partial){
+        return trySchedulePartial(t, schedule);
+    }
+
+    unsigned char temp[t->ciphlen];
+    decryptWithSchedule(schedule, t->cipher, t->ciphlen, temp);
+    return matcherContains(&t->matcher, temp, t->ciphlen);
+}
+
+/**
+ * @brief Tests if a key decrypts the ciphertext to the search target
+ *
+ * @param key Candidate DES key to test
+ * @param t Search target
+ * @return 1 if the key matches, 2 if key ^ KEY_MASK matches, 0 otherwise
+ */
+int tryTarget(long key, const SearchTarget *t){
+    DES_key_schedule schedule;
+    setKeySchedule(key, &schedule);
+    return trySchedule(t, &schedule);
+}
+
+/** Keys per Gray-code block; blocks are aligned so each covers exactly its range */
+#define GRAY_BLOCK_BITS 12
+
+/** Key schedule of each single-bit key, XORed in when that key bit flips */
+DES_key_schedule key_bit_delta[56];
+
+/**
+ * @brief Precomputes the per-bit key schedule deltas for Gray-code enumeration
+ *
+ * The DES key schedule (PC1, rotations, PC2) only moves key bits around, and
+ * OpenSSL's internal layout is a further bit permutation, so the schedule of
+ * (k ^ bit) is the schedule of k XOR the schedule of bit alone.
+ */
+void initKeyBitDeltas(void){
+    for(int b = 0; b < 56; b++){
+        setKeySchedule(1L << b, &key_bit_delta[b]);
+    }
+}
+
+/**
+ * @brief Tests keys starting at lo in Gray-code order with incremental key schedules
+ *
+ * When lo is aligned to a Gray block and the whole block fits below hi, the
+ * block [lo, lo + 2^GRAY_BLOCK_BITS) is walked as lo ^ gray(n). Consecutive
+ * keys then differ in a single bit, so the 16 subkeys are patched with one
+ * precomputed delta instead of being rebuilt. Unaligned heads and tails of a
+ * range are tested one key at a time up to the next block boundary, so the
+ * keys covered are exactly those of [lo, hi).
+ *
+ * @param lo First key to test
+ * @param hi One past the last key of the caller's range
+ * @param t Search target
+ * @param hit Pointer to store the matching key (or its complement in
+ *            complement mode), or -1 if none matched
+ * @return Number of keys tested
+ */
+long tryKeysGray(long lo, long hi, const SearchTarget *t, long *hit){
+    long block = 1L << GRAY_BLOCK_BITS;
+    long boundary = (lo | (block - 1)) + 1;
+    *hit = -1;
+
+    if((lo & (block - 1)) != 0 || boundary > hi){
+        long end = (boundary < hi) ? boundary : hi;
+        for(long key = lo; key < end; key++){
+            int m = tryTarget(key, t);
+            if(m){
+                *hit = (m == 2) ? key ^ KEY_MASK : key;
+                return key - lo + 1;
+            }
+        }
+        return end - lo;
+    }
+
+    DES_key_schedule schedule;
+    setKeySchedule(lo, &schedule);
+
+    for(long n = 0; n < block; n++){
+        if(n > 0){
+            // gray(n) and gray(n-1) differ in the bit of n's lowest set bit
+            const DES_key_schedule *delta = &key_bit_delta[__builtin_ctzl(n)];
+            for(int r = 0; r < 16; r++){
+                schedule.ks[r].deslong[0] ^= delta->ks[r].deslong[0];
+                schedule.ks[r].deslong[1] ^= delta->ks[r].deslong[1];
+            }
+        }
+
+        int m = trySchedule(t, &schedule);
+        if(m){
+            *hit = lo ^ (n ^ (n >> 1));
+            if(m == 2){
+                *hit ^= KEY_MASK;
+            }
+            return n + 1;
+        }
+    }
+    return block;
+}
+
+/**
+ * @brief Decrypts one ciphertext block under every way of an SP batch
+ *
+ * @param ks Key schedule of each way
+ * @param t Search target
+ * @param b Block index
+ * @param temp Per-way plaintext buffers of t->ciphlen + 8 bytes
+ */
+void spDecryptBlockWays(const SpSchedule ks[DES_SP_WAYS], const SearchTarget *t, int b,
+                        unsigned char temp[DES_SP_WAYS][t->ciphlen + 8]){
+    uint32_t l[DES_SP_WAYS], r[DES_SP_WAYS];
+    spInitialPerm(t->cipher + 8*b, &l[0], &r[0]);
+    for(int w = 1; w < DES_SP_WAYS; w++){
+        l[w] = l[0];
+        r[w] = r[0];
+    }
+    spCrypt(ks, l, r, 1);
+    for(int w = 0; w < DES_SP_WAYS; w++){
+        spFinalPerm(r[w], l[w], temp[w] + 8*b);
+    }
+}
+
+/**
+ * @brief Tests up to DES_SP_WAYS keys starting at lo with the SP-table core
+ *
+ * The keys of a batch run through the rounds together (see spCrypt) and
+ * follow the same strategies as trySchedule: known-block compare, partial
+ * decryption at an offset, or full decryption.
+ * Candidates that pass a filter are confirmed with a full decryption.
+ *
+ * @param lo First key to test
+ * @param hi One past the last key of the caller's range
+ * @param t Search target
+ * @param hit Pointer to store the matching key, or -1 if none matched
+ * @return Number of keys tested
+ */
+long tryKeysSp(long lo, long hi, const SearchTarget *t, long *hit){
+    SpSchedule ks[DES_SP_WAYS];
+    int n = (hi - lo < DES_SP_WAYS) ? (int)(hi - lo) : DES_SP_WAYS;
+    int len = t->ciphlen;
+    int alive[DES_SP_WAYS];
+    unsigned char temp[DES_SP_WAYS][len + 8];
+
+    if(lo % DES_SP_WAYS == 0 && n == DES_SP_WAYS){
+        spKeyScheduleWays(lo, ks);
+    } else {
+        // Unaligned head or tail: extra ways repeat the first key and are ignored
+        for(int w = 0; w < DES_SP_WAYS; w++){
+            spKeySchedule((w < n) ? lo + w : lo, &ks[w]);
+        }
+    }
+    for(int w = 0; w < DES_SP_WAYS; w++){
+        alive[w] = (w < n);
+    }
+    *hit = -1;
+
+    if(t->known_block >= 0){
+        uint32_t l[DES_SP_WAYS], r[DES_SP_WAYS], expect_l, expect_r;
+        spInitialPerm(t->known_plain, &l[0], &r[0]);
+        for(int w = 1; w < DES_SP_WAYS; w++){
+            l[w] = l[0];
+            r[w] = r[0];
+        }
+        spCrypt(ks, l, r, 0);
+        // The pre-output block R16 || L16 is IP of the ciphertext block
+        spInitialPerm(t->cipher + t->known_block, &expect_l, &expect_r);
+        for(int w = 0; w < DES_SP_WAYS; w++){
+            alive[w] = alive[w] && r[w] == expect_l && l[w] == expect_r;
+        }
+    } else if(t->partial){
+        int end = t->offset + t->search_len;
+        for(int b = t->offset / 8; 8*b < end; b++){
+            spDecryptBlockWays(ks, t, b, temp);
+            int from = (8*b > t->offset) ? 8*b : t->offset;
+            int to = (8*b + 8 < end) ? 8*b + 8 : end;
+            for(int w = 0; w < DES_SP_WAYS; w++){
+                alive[w] = alive[w] && memcmp(temp[w] + from, t->search + (from - t->offset), to - from) == 0;
+            }
+        }
+    } else {
+        for(int b = 0; 8*b < len; b++){
+            spDecryptBlockWays(ks, t, b, temp);
+        }
+    }
+
+    for(int w = 0; w < n; w++){
+        if(!alive[w]){
+            continue;
+        }
+        if(t->known_block >= 0 || t->partial){
+            // Survivor of a filter: confirm against the whole plaintext
+            spDecrypt(&ks[w], t->cipher, len, temp[w]);
+        }
+        if(matcherContains(&t->matcher, temp[w], len)){
+            *hit = lo + w;
+            return w + 1;
+        }
+    }
+    return n;
 }
 
 /**
@@ -144,6 +499,28 @@ int readEncryptedFile(char *filename, unsigned char **cipher, int *ciphlen){
     return 1;
 }
 
+/**
+ * @brief Writes encrypted data to a binary file
+ *
+ * @param filename Path to the output file
+ * @param cipher Encrypted data
+ * @param ciphlen Length of the data
+ * @return 1 on success, 0 on failure
+ */
+int writeEncryptedFile(const char *filename, const unsigned char *cipher, int ciphlen){
+    FILE *file = fopen(filename, "wb");
+    if(!file){
+        printf("Error: Cannot create file %s\n", filename);
+        return 0;
+    }
+    size_t written = fwrite(cipher, 1, ciphlen, file);
+    if(fclose(file) != 0 || written != (size_t)ciphlen){
+        printf("Error: Cannot write file %s\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
 /**
  * @brief Reads encryption parameters from input file
  *
@@ -203,6 +580,413 @@ int readInputFile(char *filename, long *key, char **plaintext, int *plainlen, ch
     return 1;
 }
 
+/** Key testing backends selectable with --engine */
+enum { ENGINE_OPENSSL, ENGINE_BITSLICE, ENGINE_SPTABLE };
+
+/** Key enumeration orders selectable with --order */
+enum { ORDER_LINEAR, ORDER_GRAY };
+
+/** Keys per block handed to an OpenMP thread; whole Gray-code blocks */
+#define THREAD_BLOCK_KEYS (1L << 16)
+
+/** Default keys per chunk of the dynamic scheduler */
+#define SCHED_DEFAULT_CHUNK (1L << 24)
+
+/** Keys tested by each thread during calibration */
+#define CALIBRATE_KEYS_PER_THREAD (1L << 18)
+
+/** Default seconds between checkpoints */
+#define CHECKPOINT_DEFAULT_EVERY 60
+
+/** Default seconds between global progress reports */
+#define PROGRESS_DEFAULT_EVERY 10
+
+/** File the --bench row is appended to unless --bench-out is given */
+#define BENCH_DEFAULT_OUT "bench.csv"
+
+/** Value of found when the search was stopped by SIGTERM instead of a match (see TERM_KEY) */
+#define SEARCH_INTERRUPTED (-1L)
+
+/** Stop value of a rank whose thread failed; the master thread aborts after the search */
+#define SEARCH_FAILED (-2L)
+
+/** Keys a thread tests between two reads of the stop flag */
+#define STOP_CHECK_KEYS 4096
+
+/** Pause of the communication thread between two polls, in nanoseconds */
+#define COMM_POLL_NS 100000
+
+/**
+ * @brief Stop value shared by the threads of a rank, alone in its cache line
+ *
+ * Every thread reads it while searching; the padding keeps writes to
+ * neighbouring variables (such as the key counter) from invalidating it.
+ */
+typedef struct {
+    long value;                   /**< Found key or SEARCH_INTERRUPTED, 0 while running */
+    char pad[64 - sizeof(long)];
+} __attribute__((aligned(64))) StopFlag;
+
+/**
+ * @brief Brute-force options given after the positional arguments
+ */
+typedef struct {
+    int engine;         /**< Key testing backend (ENGINE_*) */
+    const char *kernel; /**< Bitslice kernel name, or "auto" for cpuid dispatch */
+    int order;          /**< Key enumeration order (ORDER_*), openssl engine only */
+    int partial;        /**< Decrypt only the blocks that can decide a match */
+    int offset;         /**< Known byte offset of the search string, or -1 */
+    int known_block;    /**< Byte offset of the block the search string fills, or -1 */
+    int complement;     /**< Test each key and its complement with one key schedule */
+    const char *patterns[AC_MAX_PATTERNS]; /**< Search string followed by the --pattern strings */
+    int npatterns;      /**< Number of patterns, 1 without --pattern */
+    int match_all;      /**< Nonzero if every pattern must occur, zero if any one suffices */
+    long chunk;         /**< Keys per chunk handed out by rank 0, or 0 for static ranges */
+    const char *checkpoint; /**< Checkpoint file prefix, or NULL */
+    int checkpoint_every;   /**< Seconds between checkpoints */
+    int resume;         /**< Skip the keys recorded in the checkpoint files */
+    int calibrate;      /**< Split the keyspace in proportion to measured key rates */
+    int comm_thread;    /**< Dedicate an extra thread to MPI instead of polling from a searcher */
+    int pin;            /**< Pin ranks to NUMA nodes or sockets and threads to cores */
+    const char *results; /**< File to append the result record to, or NULL */
+    int progress_every; /**< Seconds between global progress reports */
+    long bench;         /**< Keys of the benchmark window, or 0 for a normal search */
+    const char *bench_out; /**< CSV file the benchmark row is appended to */
+    int perf;           /**< Count hardware events of each searching thread */
+    const char *trace;  /**< Chrome trace file to write, or NULL */
+} SearchOptions;
+
+/**
+ * @brief Parses the brute-force options following <encrypted.bin> <search_string>
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param opts Pointer to store the parsed options
+ * @param verbose Nonzero to print the reason of a failure
+ * @return 1 on success, 0 on an unknown or malformed option
+ */
+int parseSearchOptions(int argc, char *argv[], SearchOptions *opts, int verbose){
+    opts->engine = ENGINE_OPENSSL;
+    opts->kernel = "auto";
+    opts->order = ORDER_LINEAR;
+    opts->partial = 0;
+    opts->offset = -1;
+    opts->known_block = -1;
+    opts->complement = 0;
+    opts->patterns[0] = argv[2];
+    opts->npatterns = 1;
+    opts->match_all = 0;
+    opts->chunk = 0;
+    opts->checkpoint = NULL;
+    opts->checkpoint_every = CHECKPOINT_DEFAULT_EVERY;
+    opts->resume = 0;
+    opts->calibrate = 0;
+    opts->comm_thread = 0;
+    opts->pin = 0;
+    opts->results = NULL;
+    opts->progress_every = PROGRESS_DEFAULT_EVERY;
+    opts->bench = 0;
+    opts->bench_out = BENCH_DEFAULT_OUT;
+    opts->perf = 0;
+    opts->trace = NULL;
+
+    int kernel_given = 0;
+    for(int i = 3; i < argc; i++){
+        if(strcmp(argv[i], "--engine") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "openssl") == 0){
+                opts->engine = ENGINE_OPENSSL;
+            } else if(strcmp(argv[i], "bitslice") == 0){
+                opts->engine = ENGINE_BITSLICE;
+            } else if(strcmp(argv[i], "sptable") == 0){
+                opts->engine = ENGINE_SPTABLE;
+            } else {
+                if(verbose) printf("Error: Unknown engine %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--kernel") == 0 && i + 1 < argc){
+            opts->kernel = argv[++i];
+            if(!bsKernelKnown(opts->kernel)){
+                if(verbose) printf("Error: Unknown bitslice kernel %s (auto, scalar, avx2 or avx512)\n", opts->kernel);
+                return 0;
+            }
+            kernel_given = 1;
+        } else if(strcmp(argv[i], "--order") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "linear") == 0){
+                opts->order = ORDER_LINEAR;
+            } else if(strcmp(argv[i], "gray") == 0){
+                opts->order = ORDER_GRAY;
+            } else {
+                if(verbose) printf("Error: Unknown key order %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--partial") == 0){
+            opts->partial = 1;
+        } else if(strcmp(argv[i], "--offset") == 0 && i + 1 < argc){
+            char *end;
+            opts->offset = (int)strtol(argv[++i], &end, 10);
+            if(*end != 0 || opts->offset < 0){
+                if(verbose) printf("Error: Invalid offset %s\n", argv[i]);
+                return 0;
+            }
+            opts->partial = 1;
+        } else if(strcmp(argv[i], "--known-block") == 0 && i + 1 < argc){
+            char *end;
+            opts->known_block = (int)strtol(argv[++i], &end, 10);
+            if(*end != 0 || opts->known_block < 0 || opts->known_block % 8 != 0){
+                if(verbose) printf("Error: Known block offset must be a multiple of 8: %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--complement") == 0){
+            opts->complement = 1;
+        } else if(strcmp(argv[i], "--pattern") == 0 && i + 1 < argc){
+            i++;
+            if(argv[i][0] == 0 || opts->npatterns == AC_MAX_PATTERNS){
+                if(verbose) printf("Error: Patterns must be non-empty, at most %d in total\n", AC_MAX_PATTERNS);
+                return 0;
+            }
+            opts->patterns[opts->npatterns++] = argv[i];
+        } else if(strcmp(argv[i], "--schedule") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "static") == 0){
+                opts->chunk = 0;
+            } else if(strcmp(argv[i], "dynamic") == 0){
+                if(opts->chunk == 0) opts->chunk = SCHED_DEFAULT_CHUNK;
+            } else {
+                if(verbose) printf("Error: Unknown schedule %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--chunk") == 0 && i + 1 < argc){
+            // Whole Gray-code blocks, so bitslice and Gray batches stay aligned
+            char *end;
+            opts->chunk = strtol(argv[++i], &end, 10);
+            if(*end != 0 || opts->chunk <= 0 || opts->chunk % (1L << GRAY_BLOCK_BITS) != 0){
+                if(verbose) printf("Error: Chunk size must be a positive multiple of %ld: %s\n",
+                                   1L << GRAY_BLOCK_BITS, argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc){
+            opts->checkpoint = argv[++i];
+        } else if(strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc){
+            char *end;
+            opts->checkpoint_every = (int)strtol(argv[++i], &end, 10);
+            if(*end != 0 || opts->checkpoint_every <= 0){
+                if(verbose) printf("Error: Invalid checkpoint interval %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--resume") == 0){
+            opts->resume = 1;
+        } else if(strcmp(argv[i], "--calibrate") == 0){
+            opts->calibrate = 1;
+        } else if(strcmp(argv[i], "--comm-thread") == 0){
+            opts->comm_thread = 1;
+        } else if(strcmp(argv[i], "--pin") == 0){
+            opts->pin = 1;
+        } else if(strcmp(argv[i], "--results") == 0 && i + 1 < argc){
+            opts->results = argv[++i];
+        } else if(strcmp(argv[i], "--progress-every") == 0 && i + 1 < argc){
+            char *end;
+            opts->progress_every = (int)strtol(argv[++i], &end, 10);
+            if(*end != 0 || opts->progress_every <= 0){
+                if(verbose) printf("Error: Invalid progress interval %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--bench") == 0 && i + 1 < argc){
+            // Whole Gray-code blocks, like --chunk
+            char *end;
+            opts->bench = strtol(argv[++i], &end, 10);
+            if(*end != 0 || opts->bench <= 0 || opts->bench % (1L << GRAY_BLOCK_BITS) != 0){
+                if(verbose) printf("Error: Benchmark window must be a positive multiple of %ld: %s\n",
+                                   1L << GRAY_BLOCK_BITS, argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc){
+            opts->bench_out = argv[++i];
+        } else if(strcmp(argv[i], "--perf") == 0){
+            opts->perf = 1;
+        } else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc){
+            opts->trace = argv[++i];
+        } else if(strcmp(argv[i], "--match") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "any") == 0){
+                opts->match_all = 0;
+            } else if(strcmp(argv[i], "all") == 0){
+                opts->match_all = 1;
+            } else {
+                if(verbose) printf("Error: Unknown match mode %s\n", argv[i]);
+                return 0;
+            }
+        } else {
+            if(verbose) printf("Error: Unknown option %s\n", argv[i]);
+            return 0;
+        }
+    }
+    if(kernel_given && opts->engine != ENGINE_BITSLICE){
+        if(verbose) printf("Error: --kernel needs --engine bitslice\n");
+        return 0;
+    }
+    if(opts->resume && !opts->checkpoint){
+        if(verbose) printf("Error: --resume needs --checkpoint <prefix>\n");
+        return 0;
+    }
+    if(opts->bench > 0 && opts->checkpoint){
+        if(verbose) printf("Error: --bench cannot be combined with --checkpoint\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Key testing backend chosen by the options, shared by all threads of a rank
+ */
+typedef struct {
+    int engine;                 /**< Key testing backend (ENGINE_*) */
+    int order;                  /**< Key enumeration order (ORDER_*), openssl engine only */
+    const SearchTarget *target; /**< Search target */
+    BitsliceKernel bs_kernel;   /**< Selected kernel (bitslice engine) */
+    const BitsliceCtx *bs_ctx;  /**< Precomputed ciphertext (bitslice engine) */
+} SearchEngine;
+
+/**
+ * @brief Tests the key i, or the batch of keys starting at it, with the selected engine
+ *
+ * @param e Search engine
+ * @param work Per-thread bitslice buffers (bitslice engine)
+ * @param i First key to test
+ * @param hi One past the last key of the caller's range
+ * @param hit Pointer to store the matching key, or -1 if none matched
+ * @return Number of keys tested
+ */
+long tryKeysEngine(const SearchEngine *e, BitsliceWork *work, long i, long hi, long *hit){
+    *hit = -1;
+    if(e->engine == ENGINE_BITSLICE){
+        long base = i & ~(long)(e->bs_kernel.lanes - 1);
+        uint64_t match[BS_MAX_LANES / 64];
+        long step = base + e->bs_kernel.lanes - i;
+        if(step > hi - i){
+            step = hi - i;
+        }
+        if(e->bs_kernel.search(e->bs_ctx, work, base, i, hi, match)){
+            // Stop right after the hit, so the next call tests the rest of the batch
+            *hit = base + bsFirstLane(match, e->bs_kernel.lanes / 64);
+            return *hit - i + 1;
+        }
+        return step;
+    }
+    if(e->engine == ENGINE_SPTABLE){
+        return tryKeysSp(i, hi, e->target, hit);
+    }
+    if(e->order == ORDER_GRAY){
+        return tryKeysGray(i, hi, e->target, hit);
+    }
+    int m = tryTarget(i, e->target);
+    if(m){
+        *hit = (m == 2) ? i ^ KEY_MASK : i;
+    }
+    return 1;
+}
+
+/**
+ * @brief Measures the key rate of this rank on a fixed sample of keys
+ *
+ * Every thread tests CALIBRATE_KEYS_PER_THREAD keys from sample on with the
+ * selected engine, exactly as the search does. Matches are ignored: the
+ * sample keys are searched again as part of the rank's range.
+ *
+ * @param e Search engine
+ * @param sample First key of the sample (multiple of the Gray block size)
+ * @param pin_cpus CPUs to pin the threads to, as in the search (see topoRankCpus)
+ * @param npin Number of CPUs, 0 to leave placement to the OS
+ * @param threads Threads to test with (1 gives the serial rate)
+ * @return Keys per second of the whole rank
+ */
+double calibrateRate(const SearchEngine *e, long sample, const int *pin_cpus, int npin, int threads){
+    long total = 0;
+    int failed = 0;
+    double start = MPI_Wtime();
+
+    // MPI is funneled through the calling thread, so a failing thread only flags it
+    #pragma omp parallel num_threads(threads) reduction(+:total)
+    {
+        if(npin > 0){
+            topoPinThread(pin_cpus, npin, omp_get_thread_num());
+        }
+
+        BitsliceWork work;
+        if(e->engine == ENGINE_BITSLICE && !bsInitWork(&work, e->bs_ctx)){
+            printf("Error: Cannot allocate bitslice buffers\n");
+            #pragma omp atomic write
+            failed = 1;
+        } else {
+            long lo = sample + omp_get_thread_num() * CALIBRATE_KEYS_PER_THREAD;
+            long hi = lo + CALIBRATE_KEYS_PER_THREAD;
+            long hit;
+            for(long i = lo; i < hi; i += tryKeysEngine(e, &work, i, hi, &hit)){
+            }
+            total += hi - lo;
+        }
+
+        if(e->engine == ENGINE_BITSLICE){
+            bsFreeWork(&work);
+        }
+    }
+    if(failed){
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return total / (MPI_Wtime() - start);
+}
+
+/**
+ * @brief First key of a rank's range when [0, upper) is split in proportion to rates
+ *
+ * Every rank computes the same boundaries, so the ranges tile the keyspace.
+ *
+ * @param rates Keys per second of each rank
+ * @param N Number of ranks
+ * @param rank Rank whose range starts here (N gives upper)
+ * @param upper Size of the keyspace
+ * @return First key of the range
+ */
+long weightedLower(const double *rates, int N, int rank, long upper){
+    long double before = 0, total = 0;
+    for(int r = 0; r < N; r++){
+        total += rates[r];
+        if(r < rank){
+            before += rates[r];
+        }
+    }
+    return (rank >= N) ? upper : (long)(upper * (before / total));
+}
+
+/** Set by SIGTERM; the search then saves a final checkpoint and stops */
+volatile sig_atomic_t search_interrupted = 0;
+
+/** Stop value of this rank's search, read by every thread */
+StopFlag search_stop = { 0 };
+
+/**
+ * @brief SIGTERM handler: asks the search to stop at the next poll
+ */
+void onSigterm(int sig){
+    (void)sig;
+    search_interrupted = 1;
+}
+
+/**
+ * @brief Writes this rank's checkpoint, warning if it cannot
+ *
+ * @param opts Search options (checkpoint must be set)
+ * @param id MPI rank
+ * @param tag Search tag (see checkpointTag)
+ * @param searched Keys searched so far
+ */
+void saveCheckpoint(const SearchOptions *opts, int id, uint64_t tag, const IntervalSet *searched){
+    if(!checkpointWrite(opts->checkpoint, id, tag, searched)){
+        printf("[Process %d] Warning: Cannot write checkpoint %s.%d\n", id, opts->checkpoint, id);
+    }
+}
+
 /**
  * @brief Main entry point for DES encryption/brute-force program
  *
@@ -216,34 +1000,38 @@ int readInputFile(char *filename, long *key, char **plaintext, int *plainlen, ch
  * @param argc Argument count
  * @param argv Argument vector
  *   Encryption mode: program <input.txt> <output.bin>
- *   Brute-force mode: program <encrypted.bin> <search_string>
+ *   Brute-force mode: program <encrypted.bin> <search_string> [options]
  * @return 0 on success, 1 on error
  */
 int main(int argc, char *argv[]){
     int N, id;
     long upper = (1L << 56); // Upper bound for DES keys: 2^56
     long mylower, myupper;
-    MPI_Status st;
-    MPI_Request req;
     int ciphlen;
     MPI_Comm comm = MPI_COMM_WORLD;
 
-    MPI_Init(&argc, &argv);
+    // Only the master thread calls MPI, also when it is the communication thread
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
     MPI_Comm_size(comm, &N);
     MPI_Comm_rank(comm, &id);
+    PhaseTimer timer;
+    phaseInit(&timer);
+    if(thread_support < MPI_THREAD_FUNNELED && id == 0){
+        printf("Warning: The MPI library does not support MPI_THREAD_FUNNELED\n");
+    }
 
     // Determine mode based on arguments
     int encrypt_mode = 0; // 0 = brute force mode, 1 = encrypt mode
 
-    if(argc == 3){
-        // Mode: Encrypt from input.txt
+    // Mode: Encrypt from input.txt, optionally with keys placed in a rank's range
+    if(argc >= 3 && strstr(argv[1], ".txt") != NULL){
         char *filename = argv[1];
         char *output_bin = argv[2];
+        WorkloadSpec workload;
+        encrypt_mode = 1;
 
-        // Check if first argument is a .txt file (encrypt mode)
-        if(strstr(filename, ".txt") != NULL){
-            encrypt_mode = 1;
-
+        if(workloadParse(argc, argv, 3, 0, &workload, id == 0)){
             if(id == 0){
                 printf("=== DES Encryption Mode ===\n");
 
@@ -256,32 +1044,63 @@ int main(int argc, char *argv[]){
                 }
 
                 printf("Input file: %s\n", filename);
-                printf("Encryption key: %ld\n", encryption_key);
                 printf("Plaintext: %s\n", plaintext);
                 printf("Plaintext length (padded): %d bytes\n", ciphlen);
-                printf("Output file: %s\n\n", output_bin);
 
                 unsigned char *cipher = (unsigned char *)malloc(ciphlen);
-                encrypt(encryption_key, (unsigned char *)plaintext, ciphlen, cipher);
+                if(workload.nfractions == 0){
+                    printf("Encryption key: %ld\n", encryption_key);
+                    printf("Output file: %s\n\n", output_bin);
 
-                //Write to binary file
-                FILE *file = fopen(output_bin, "wb");
-                if(!file){
-                    printf("Error: Cannot create file %s\n", output_bin);
-                    MPI_Abort(comm, 1);
-                }
-
-                fwrite(cipher, 1, ciphlen, file);
-                fclose(file);
+                    encrypt(encryption_key, (unsigned char *)plaintext, ciphlen, cipher);
+                    if(!writeEncryptedFile(output_bin, cipher, ciphlen)){
+                        MPI_Abort(comm, 1);
+                    }
 
-                printf("--- Encryption Complete ---\n");
-                printf("Ciphertext (hex): ");
-                for(int i=0; i<ciphlen && i<32; i++){
-                    printf("%02x ", cipher[i]);
+                    printf("--- Encryption Complete ---\n");
+                    printf("Ciphertext (hex): ");
+                    for(int i=0; i<ciphlen && i<32; i++){
+                        printf("%02x ", cipher[i]);
+                    }
+                    if(ciphlen > 32) printf("...");
+                    printf("\n\n");
+                    printf("File saved: %s\n", output_bin);
+                } else {
+                    // Synthetic corpus: the key of the input file is replaced by keys at
+                    // the given fractions of the chosen ranks' static ranges
+                    int first = (workload.rank == WORKLOAD_ALL_RANKS) ? 0 : workload.rank;
+                    int last = (workload.rank == WORKLOAD_ALL_RANKS) ? workload.ranks - 1 : workload.rank;
+                    int single = (first == last && workload.nfractions == 1);
+                    char manifest_name[512];
+                    workloadManifestName(output_bin, manifest_name, sizeof(manifest_name));
+                    FILE *manifest = fopen(manifest_name, "w");
+                    if(!manifest){
+                        printf("Error: Cannot create file %s\n", manifest_name);
+                        MPI_Abort(comm, 1);
+                    }
+                    fprintf(manifest, "file,ranks,rank,fraction,key\n");
+
+                    printf("Keys placed in the static ranges of %d processes\n\n", workload.ranks);
+                    for(int r = first; r <= last; r++){
+                        for(int f = 0; f < workload.nfractions; f++){
+                            char name[512];
+                            long key = workloadKey(upper, workload.ranks, r, workload.fractions[f]);
+                            if(single){
+                                snprintf(name, sizeof(name), "%s", output_bin);
+                            } else {
+                                workloadFileName(output_bin, r, workload.fractions[f], name, sizeof(name));
+                            }
+                            encrypt(key, (unsigned char *)plaintext, ciphlen, cipher);
+                            if(!writeEncryptedFile(name, cipher, ciphlen)){
+                                MPI_Abort(comm, 1);
+                            }
+                            fprintf(manifest, "%s,%d,%d,%g,%ld\n", name, workload.ranks, r, workload.fractions[f], key);
+                            printf("%s: key %ld (process %d, %g of its range)\n", name, key, r, workload.fractions[f]);
+                        }
+                    }
+                    fclose(manifest);
+                    printf("\nKeys listed in: %s\n", manifest_name);
                 }
-                if(ciphlen > 32) printf("...");
-                printf("\n\n");
-                printf("File saved: %s\n", output_bin);
                 if(search != NULL){
                     printf("Search string for decryption: \"%s\"\n", search);
                 }
@@ -296,20 +1115,78 @@ int main(int argc, char *argv[]){
         }
     }
 
-    if(argc != 3 || encrypt_mode){
+    SearchOptions opts;
+    if(argc < 3 || encrypt_mode || !parseSearchOptions(argc, argv, &opts, id == 0)){
         if(id == 0){
             printf("Usage:\n");
             printf("  Encrypt mode:\n");
-            printf("    mpirun -np <N> %s <input.txt> <output.bin>\n", argv[0]);
+            printf("    mpirun -np <N> %s <input.txt> <output.bin> [options]\n", argv[0]);
             printf("    input.txt format:\n");
             printf("      Line 1: Encryption key (integer)\n");
             printf("      Line 2: Text to encrypt\n");
             printf("      Line 3: Search substring (for verification)\n");
+            printf("    Options (synthetic workloads, replace the key of input.txt):\n");
+            printf("      --ranks <N>                Place keys in the static ranges of N processes\n");
+            printf("      --rank <r>|all             Process whose range holds the key (default: 0)\n");
+            printf("      --at <f>[,<f>...]          Fractions of the range, 0 = first key searched,\n");
+            printf("                                 1 = last; several keys give one file each,\n");
+            printf("                                 <output>_r<r>_f<f>.bin, listed in <output>_keys.csv\n");
             printf("\n");
             printf("  Brute force mode:\n");
-            printf("    mpirun -np <N> %s <encrypted.bin> <search_string>\n", argv[0]);
+            printf("    mpirun -np <N> %s <encrypted.bin> <search_string> [options]\n", argv[0]);
             printf("    encrypted.bin: Binary file with encrypted data\n");
             printf("    search_string: Text fragment to search for\n");
+            printf("    Options:\n");
+            printf("      --engine openssl|bitslice|sptable\n");
+            printf("                                 Key testing backend (default: openssl)\n");
+            printf("      --kernel auto|scalar|avx2|avx512\n");
+            printf("                                 Bitslice kernel, needs --engine bitslice (default:\n");
+            printf("                                 widest supported)\n");
+            printf("      --order linear|gray        Key order for the openssl engine; gray patches\n");
+            printf("                                 the key schedule incrementally (default: linear)\n");
+            printf("      --partial                  Decrypt only the blocks that can decide a match\n");
+            printf("                                 (needs --offset)\n");
+            printf("      --offset <n>               Search string is known to start at byte n\n");
+            printf("                                 (implies --partial)\n");
+            printf("      --known-block <n>          The 8-byte block at byte n (multiple of 8) is the\n");
+            printf("                                 search string, NUL-padded if shorter; keys are\n");
+            printf("                                 tested by encrypting it and comparing blocks\n");
+            printf("      --complement               Search 2^55 keys, testing each key and its\n");
+            printf("                                 complement (needs a known block, openssl engine)\n");
+            printf("      --pattern <text>           Additional pattern; may be repeated, all patterns\n");
+            printf("                                 are searched in one pass (Aho-Corasick)\n");
+            printf("      --match any|all            Accept a key when any or all patterns occur\n");
+            printf("                                 (default: any)\n");
+            printf("      --schedule static|dynamic  static: fixed range per process (default);\n");
+            printf("                                 dynamic: rank 0 hands out chunks on request\n");
+            printf("      --chunk <n>                Keys per dynamic chunk, multiple of %ld\n", 1L << GRAY_BLOCK_BITS);
+            printf("                                 (implies dynamic, default: %ld)\n", SCHED_DEFAULT_CHUNK);
+            printf("      --checkpoint <prefix>      Save the searched key intervals of each process\n");
+            printf("                                 to <prefix>.<rank>, periodically and on SIGTERM\n");
+            printf("      --checkpoint-every <s>     Seconds between checkpoints (default: %d)\n", CHECKPOINT_DEFAULT_EVERY);
+            printf("      --resume                   Skip the keys recorded in the checkpoint files\n");
+            printf("      --calibrate                Measure each process's key rate first and give it\n");
+            printf("                                 a share of the keyspace in proportion (static)\n");
+            printf("      --comm-thread              Run all MPI traffic on an extra thread per process;\n");
+            printf("                                 searching threads only read a stop flag\n");
+            printf("      --pin                      One process per NUMA node (or socket) of each\n");
+            printf("                                 machine, threads pinned to physical cores first\n");
+            printf("      --results <file>           Append a result record with per-phase times;\n");
+            printf("                                 JSON Lines if <file> ends in .json, else CSV\n");
+            printf("      --progress-every <s>       Seconds between global progress reports with\n");
+            printf("                                 keys/sec, keyspace covered and ETA (default: %d)\n",
+                   PROGRESS_DEFAULT_EVERY);
+            printf("      --bench <n>                Benchmark: sweep keys [0, n) whole (multiple of %ld),\n",
+                   1L << GRAY_BLOCK_BITS);
+            printf("                                 report keys/sec per thread, process and in total,\n");
+            printf("                                 and speedup and efficiency over one thread\n");
+            printf("      --bench-out <file>         CSV file the benchmark row is appended to\n");
+            printf("                                 (default: %s)\n", BENCH_DEFAULT_OUT);
+            printf("      --perf                     Count cycles, instructions, L1D and branch misses\n");
+            printf("                                 of each searching thread (perf_event_open) and\n");
+            printf("                                 report them per key tested\n");
+            printf("      --trace <file>             Write a timeline of every rank and thread (blocks,\n");
+            printf("                                 polls, stop) in Chrome trace JSON format\n");
         }
         MPI_Finalize();
         return 1;
@@ -341,6 +1218,10 @@ int main(int argc, char *argv[]){
         printf("\n\n");
     }
 
+    // Waiting for rank 0 to read the file counts as setup, not as broadcast
+    MPI_Barrier(comm);
+    phaseEnd(&timer, PHASE_SETUP);
+
     // Broadcast ciphertext length to all processes
     MPI_Bcast(&ciphlen, 1, MPI_INT, 0, comm);
 
@@ -352,11 +1233,133 @@ int main(int argc, char *argv[]){
     // Broadcast ciphertext and search string to all processes
     MPI_Bcast(cipher, ciphlen, MPI_UNSIGNED_CHAR, 0, comm);
     MPI_Bcast(search, 256, MPI_CHAR, 0, comm);
+    phaseEnd(&timer, PHASE_BCAST);
+
+    // The whole plaintext is searched, so without an offset every block can decide a match
+    if(opts.partial && opts.offset < 0){
+        if(id == 0){
+            printf("Note: --partial has no effect without --offset\n");
+        }
+        opts.partial = 0;
+    }
+
+    SearchTarget target = {
+        .cipher = cipher,
+        .ciphlen = ciphlen,
+        .search = search,
+        .search_len = (int)strlen(search),
+        .offset = opts.offset,
+        .partial = opts.partial,
+        .known_block = -1,
+    };
+    matcherInit(&target.matcher, search, target.search_len);
+
+    // Several patterns: one automaton scans the plaintext once for all of them
+    AcAutomaton ac = {0};
+    opts.patterns[0] = search;
+    if(opts.npatterns > 1){
+        int lens[AC_MAX_PATTERNS];
+        for(int p = 0; p < opts.npatterns; p++){
+            lens[p] = (int)strlen(opts.patterns[p]);
+        }
+        if(!acInit(&ac, opts.patterns, lens, opts.npatterns)){
+            printf("Error: Cannot build the pattern automaton\n");
+            MPI_Abort(comm, 1);
+        }
+        matcherInitMulti(&target.matcher, &ac, opts.match_all);
+
+        // Offset and known-block filters pin the search string, which only holds
+        // when it is required, i.e. in all mode
+        if(!opts.match_all && (opts.offset >= 0 || opts.known_block >= 0 || opts.complement)){
+            if(id == 0){
+                printf("Error: --offset, --known-block and --complement need --match all with --pattern\n");
+            }
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    if(opts.offset >= 0 && opts.offset + target.search_len > ciphlen){
+        if(id == 0){
+            printf("Error: Search string at offset %d does not fit in %d bytes\n", opts.offset, ciphlen);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    // A block-aligned offset with at least 8 search bytes pins a whole plaintext block
+    if(opts.known_block < 0 && opts.offset >= 0 && opts.offset % 8 == 0 && target.search_len >= 8){
+        opts.known_block = opts.offset;
+    }
+    if(opts.known_block >= 0){
+        if(opts.known_block + 8 > ciphlen){
+            if(id == 0){
+                printf("Error: Known block at offset %d is outside the %d-byte ciphertext\n",
+                       opts.known_block, ciphlen);
+            }
+            MPI_Finalize();
+            return 1;
+        }
+        // Shorter search strings are padded with NULs, like readInputFile pads the plaintext
+        target.known_block = opts.known_block;
+        memset(target.known_plain, 0, 8);
+        memcpy(target.known_plain, search, (target.search_len < 8) ? target.search_len : 8);
+    }
+
+    // E(~k, ~p) = ~E(k, p): with a known block, every key also tests its complement,
+    // so only keys with the top bit clear need to be enumerated
+    if(opts.complement){
+        if(target.known_block < 0 || opts.engine != ENGINE_OPENSSL){
+            if(id == 0){
+                printf("Error: --complement needs a known plaintext block and the openssl engine\n");
+            }
+            MPI_Finalize();
+            return 1;
+        }
+        target.complement = 1;
+        setKeySchedule(KEY_MASK, &key_complement_delta);
+        upper >>= 1;
+    }
+
+    // Checkpoints: every rank starts from the union of all files of the previous run
+    IntervalSet resumed = {0}, searched = {0};
+    uint64_t checkpoint_tag = 0;
+    if(opts.checkpoint){
+        checkpoint_tag = checkpointTag(cipher, ciphlen, opts.patterns, opts.npatterns, opts.match_all,
+                                       opts.offset, opts.known_block, upper);
+        if(opts.resume){
+            int n = 0;
+            if(id == 0){
+                int files = checkpointRead(opts.checkpoint, checkpoint_tag, &resumed);
+                if(files < 0){
+                    MPI_Abort(comm, 1);
+                }
+                printf("Resumed from %d checkpoint files: %ld keys already searched\n",
+                       files, intervalTotal(&resumed));
+                n = resumed.n;
+            }
+            MPI_Bcast(&n, 1, MPI_INT, 0, comm);
+            if(id != 0 && n > 0){
+                resumed.iv = (long (*)[2])malloc(sizeof(*resumed.iv) * n);
+                resumed.n = resumed.cap = n;
+            }
+            MPI_Bcast(resumed.iv, 2 * n, MPI_LONG, 0, comm);
+            for(int i = 0; i < n; i++){
+                intervalAdd(&searched, resumed.iv[i][0], resumed.iv[i][1]);
+            }
+        }
+        signal(SIGTERM, onSigterm);
+    }
+
+    // Benchmark: a fixed window from key 0, swept whole whatever it contains
+    if(opts.bench > 0){
+        upper = opts.bench;
+    }
 
     // Divide keyspace among MPI processes
     long range_per_node = upper / N;
     mylower = range_per_node * id;
-    myupper = range_per_node * (id+1) - 1;
+    myupper = range_per_node * (id+1);
     if(id == N-1){
         // Last process handles remainder
         myupper = upper;
@@ -365,87 +1368,454 @@ int main(int argc, char *argv[]){
     if(id == 0){
         printf("--- Brute Force Search ---\n");
         printf("Total processes: %d\n", N);
-        printf("Search space: 2^56 = %ld keys\n", upper);
-        printf("Keys per process: ~%ld\n", range_per_node);
+        if(opts.bench > 0){
+            printf("Benchmark window: %ld keys from key 0, no early exit\n", upper);
+        } else if(target.complement){
+            printf("Search space: 2^55 = %ld keys, each tested with its complement\n", upper);
+        } else {
+            printf("Search space: 2^56 = %ld keys\n", upper);
+        }
+        if(opts.chunk > 0){
+            printf("Dynamic schedule: chunks of %ld keys handed out by rank 0\n", opts.chunk);
+        } else if(opts.calibrate){
+            printf("Keys per process: in proportion to calibrated key rates\n");
+        } else {
+            printf("Keys per process: ~%ld\n", range_per_node);
+        }
         printf("Starting search...\n\n");
     }
+    if(opts.calibrate && opts.chunk > 0){
+        if(id == 0){
+            printf("Note: --calibrate has no effect with the dynamic schedule\n");
+        }
+        opts.calibrate = 0;
+    }
+
+    long found = 0;
+    // One-sided stop signal: the finder publishes the key in rank 0's result slot
+    Termination term;
+    termInit(&term, comm);
+
+    // Placement: the ranks of a machine are spread over its NUMA nodes (or sockets)
+    // before sharing one, and threads fill physical cores before SMT siblings.
+    // Pinned before the engine tables are built, so they are first touched locally
+    int pin_cpus[TOPO_MAX_CPUS];
+    int npin = 0;
+    if(opts.pin){
+        static Topology topo;
+        MPI_Comm node_comm;
+        int local_rank, local_size, domain, ncores;
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, id, MPI_INFO_NULL, &node_comm);
+        MPI_Comm_rank(node_comm, &local_rank);
+        MPI_Comm_size(node_comm, &local_size);
+        MPI_Comm_free(&node_comm);
+
+        topoProbe(&topo, "/sys/devices/system");
+        if(id == 0){
+            printf("Topology: %d CPUs, %d cores, %d sockets, %d NUMA nodes\n",
+                   topo.ncpus, topo.ncores, topo.npackages, topo.nnodes);
+        }
+        npin = topoRankCpus(&topo, local_rank, local_size, pin_cpus, &domain, &ncores);
+        if(!topoPin(pin_cpus, npin)){
+            printf("[Process %d] Warning: Cannot pin to the CPUs of %s %d, placement left to the OS\n",
+                   id, topo.numa ? "NUMA node" : "socket", domain);
+            npin = 0;
+        } else {
+            // Default: one thread per hardware thread of the share
+            if(getenv("OMP_NUM_THREADS") == NULL){
+                omp_set_num_threads(npin);
+            }
+            int threads = omp_get_max_threads();
+            char map[1024];
+            int len = 0;
+            for(int t = 0; t < threads && len < (int)sizeof(map) - 16; t++){
+                len += snprintf(map + len, sizeof(map) - len, " %d", pin_cpus[t % npin]);
+            }
+            printf("[Process %d] Pinned to %s %d (%d cores, %d CPUs), thread CPUs:%s\n",
+                   id, topo.numa ? "NUMA node" : "socket", domain, ncores, npin, map);
+        }
+    }
+
+    // Bitsliced engine: tables and ciphertext precomputation shared by all threads
+    // Each rank picks its own kernel, so mixed-generation nodes all run their widest one
+    BitsliceCtx bs_ctx;
+    BitsliceKernel bs_kernel;
+    if(opts.engine == ENGINE_BITSLICE){
+        if(!bsSelectKernel(opts.kernel, &bs_kernel)){
+            printf("Error: Bitslice kernel %s is not available on this CPU\n", opts.kernel);
+            MPI_Abort(comm, 1);
+        }
+        bsInitTables();
+        if(!bsInitContext(&bs_ctx, cipher, ciphlen, search, &target.matcher)){
+            printf("Error: Cannot allocate bitslice context\n");
+            MPI_Abort(comm, 1);
+        }
+        bs_ctx.partial = opts.partial;
+        bs_ctx.offset = opts.offset;
+        if(target.known_block >= 0){
+            bsSetKnownBlock(&bs_ctx, target.known_block / 8, target.known_plain);
+        }
+        printf("[Process %d] Engine: bitslice, %s kernel (%d keys per pass)\n",
+               id, bs_kernel.name, bs_kernel.lanes);
+    } else if(opts.engine == ENGINE_SPTABLE){
+        spInitTables();
+        printf("[Process %d] Engine: sptable, %d interleaved keys\n", id, DES_SP_WAYS);
+    } else if(opts.order == ORDER_GRAY){
+        initKeyBitDeltas();
+        if(id == 0){
+            printf("Key order: Gray code (blocks of %ld keys)\n", 1L << GRAY_BLOCK_BITS);
+        }
+    }
+    if(id == 0 && target.known_block >= 0){
+        printf("Known-plaintext block compare: block at byte %d\n", target.known_block);
+    } else if(id == 0 && opts.partial){
+        printf("Partial decryption: search string at byte %d\n", opts.offset);
+    }
+    if(id == 0){
+        printf("Matcher: %s\n", target.matcher.name);
+        if(opts.npatterns > 1){
+            printf("Patterns: %d (%d automaton states)\n", opts.npatterns, ac.nstates);
+        }
+    }
+
+    SearchEngine engine = { .engine = opts.engine, .order = opts.order, .target = &target };
+    if(opts.engine == ENGINE_BITSLICE){
+        engine.bs_kernel = bs_kernel;
+        engine.bs_ctx = &bs_ctx;
+    }
+
+    // Benchmark baseline: one thread of rank 0 with the same engine, while the
+    // other ranks wait, so the sweep then starts on every rank together
+    double serial_rate = 0;
+    if(opts.bench > 0){
+        if(id == 0){
+            serial_rate = calibrateRate(&engine, 0, pin_cpus, npin, 1);
+            printf("Serial baseline: %.0f keys/sec (1 thread)\n", serial_rate);
+        }
+        MPI_Barrier(comm);
+    }
+
+    // Heterogeneous nodes: every rank times the same engine on a sample, then the
+    // keyspace is cut so all ranks reach the end of their range together
+    if(opts.calibrate){
+        double rate = calibrateRate(&engine, mylower & ~((1L << GRAY_BLOCK_BITS) - 1), pin_cpus, npin,
+                                    omp_get_max_threads());
+        double rates[N];
+        MPI_Allgather(&rate, 1, MPI_DOUBLE, rates, 1, MPI_DOUBLE, comm);
+        mylower = weightedLower(rates, N, id, upper);
+        myupper = weightedLower(rates, N, id + 1, upper);
+        printf("[Process %d] Calibrated rate: %.0f keys/sec (%.1f%% of the keyspace)\n",
+               id, rate, 100.0 * (myupper - mylower) / upper);
+    }
 
     int num_threads = omp_get_max_threads();
-    printf("[Process %d] Searching range: %ld to %ld with %d OpenMP threads\n",
-           id, mylower, myupper, num_threads);
+    const char *comm_note = opts.comm_thread ? " and a communication thread" : "";
+    if(opts.chunk > 0){
+        printf("[Process %d] Searching dynamic chunks with %d OpenMP threads%s\n", id, num_threads, comm_note);
+    } else {
+        printf("[Process %d] Searching range: %ld to %ld with %d OpenMP threads%s\n",
+               id, mylower, myupper - 1, num_threads, comm_note);
+    }
 
-    long found = 0;
-    // Set up non-blocking receive to detect when another process finds the key
-    MPI_Irecv(&found, 1, MPI_LONG, MPI_ANY_SOURCE, MPI_ANY_TAG, comm, &req);
+    ChunkScheduler sched;
+    schedInit(&sched, comm, mylower, (opts.chunk > 0) ? upper : myupper, opts.chunk,
+              opts.resume ? &resumed : NULL);
+    long chunk_lower = 0, chunk_upper = 0;
+    long next_block = 0;
+    int have_chunk = 0;
+    int workers_done = 0;
+    // Set by a thread that cannot go on: only the master thread may call MPI_Abort
+    int search_failed = 0;
+
+    // Rank 0 reports the progress of all ranks, summed with nonblocking reductions
+    ProgressReporter progress;
+    progressInit(&progress, comm, opts.progress_every, upper, intervalTotal(&resumed));
+
+    // Timeline of blocks, polls and the stop, one ring buffer per thread
+    Tracer trace;
+    traceInit(&trace, comm, opts.trace != NULL, num_threads + opts.comm_thread, opts.comm_thread);
 
     time_t start_time = time(NULL);
     long keys_tested = 0;
-    int flag = 0;
+    long hits = 0;
+    double thread_rates[num_threads]; // Keys/sec of each searching thread (--bench)
+    double perf_totals[PERF_NCOUNTERS] = {0}; // Events of all searching threads (--perf)
+    int perf_available[PERF_NCOUNTERS];
+    int perf_error = 0;
+    for(int c = 0; c < PERF_NCOUNTERS; c++){
+        perf_available[c] = 1;
+    }
+    phaseEnd(&timer, PHASE_SETUP);
 
-    // Parallel key search using OpenMP threads within each MPI process
-    #pragma omp parallel shared(found, cipher, ciphlen, search, req, flag, st)
+    // Parallel key search using OpenMP threads within each MPI process. With
+    // --comm-thread the master thread does not search: it runs the MPI polling
+    // loop next to num_threads searching threads
+    #pragma omp parallel num_threads(num_threads + opts.comm_thread) shared(found, cipher, ciphlen, search)
     {
         int thread_id = omp_get_thread_num();
-        int total_threads = omp_get_num_threads();
+        int polls_mpi = (thread_id == 0 && !opts.comm_thread);
+        if(npin > 0){
+            // The communication thread may run on any CPU of the rank
+            topoPinThread(pin_cpus, npin, thread_id - opts.comm_thread);
+        }
         long local_keys_tested = 0;
+        long thread_keys = 0;
+        long next_poll = 0;
+        long next_stop_check = 0;
+        double thread_start = omp_get_wtime();
+        time_t next_checkpoint = start_time + opts.checkpoint_every;
+
+        // A failure is seen by the master at the first fetch, so no range is searched
+        BitsliceWork bs_work;
+        if(opts.engine == ENGINE_BITSLICE && !bsInitWork(&bs_work, &bs_ctx)){
+            printf("Error: Cannot allocate bitslice buffers\n");
+            #pragma omp atomic write
+            search_failed = 1;
+        }
 
-        // Each thread gets its own portion of the process's keyspace range
-        long range_size = myupper - mylower;
-        long keys_per_thread = range_size / total_threads;
-        long thread_lower = mylower + thread_id * keys_per_thread;
-        long thread_upper = (thread_id == total_threads - 1) ? myupper : thread_lower + keys_per_thread;
-
-        for(long i = thread_lower; i < thread_upper; ++i){
-            // Check if key was found by any thread (shared variable)
-            int local_found = 0;
-            #pragma omp atomic read
-            local_found = found;
+        // Hardware counters of this searching thread, running only while it searches
+        // its blocks: the barriers and the master's range fetches are left out
+        PerfCounters perf;
+        int counting = opts.perf && thread_id >= opts.comm_thread;
+        if(counting){
+            perfOpen(&perf);
+        }
 
-            if(local_found != 0){
+        for(;;){
+            // The master thread fetches the next range, so MPI stays on one thread
+            #pragma omp barrier
+            #pragma omp master
+            {
+                double fetch_start = traceNow(&trace);
+                int failed;
+                #pragma omp atomic read
+                failed = search_failed;
+                have_chunk = (found == 0) && !failed && schedNext(&sched, &chunk_lower, &chunk_upper, &term);
+                traceSpan(&trace, 0, TRACE_SCHEDULE, fetch_start, have_chunk ? chunk_lower : 0,
+                          have_chunk ? chunk_upper : 0);
+                next_block = 0;
+                workers_done = 0;
+            }
+            #pragma omp barrier
+            if(!have_chunk){
                 break;
             }
 
-            // Check if key was found by another process (only master thread checks MPI)
-            if(thread_id == 0 && local_keys_tested % 10000 == 0){
-                MPI_Test(&req, &flag, &st);
-                if(flag && found != 0){
-                    break;
+            if(opts.comm_thread && thread_id == 0){
+                // Communication thread: serves chunk requests, writes checkpoints,
+                // publishes and polls the stop signal and sums the progress until
+                // every searching thread is done with this range
+                const struct timespec pause = { 0, COMM_POLL_NS };
+                for(;;){
+                    int done;
+                    #pragma omp atomic read
+                    done = workers_done;
+                    if(done == num_threads){
+                        break;
+                    }
+
+                    double poll_start = traceNow(&trace);
+                    if(id == 0){
+                        schedServe(&sched);
+                    }
+                    if(opts.checkpoint && time(NULL) >= next_checkpoint){
+                        next_checkpoint = time(NULL) + opts.checkpoint_every;
+                        #pragma omp critical(checkpoint)
+                        saveCheckpoint(&opts, id, checkpoint_tag, &searched);
+                    }
+
+                    long stop_value;
+                    #pragma omp atomic read
+                    stop_value = search_stop.value;
+                    if(stop_value == 0){
+                        stop_value = search_interrupted ? SEARCH_INTERRUPTED : termPoll(&term);
+                        if(stop_value != 0){
+                            traceInstant(&trace, thread_id, TRACE_STOP, stop_value);
+                            #pragma omp critical
+                            {
+                                if(found == 0){
+                                    found = stop_value;
+                                    if(stop_value == SEARCH_INTERRUPTED){
+                                        printf("[Process %d] Interrupted, stopping the search\n", id);
+                                    }
+                                }
+                                #pragma omp atomic write
+                                search_stop.value = found;
+                            }
+                        }
+                    }
+                    if(stop_value != 0 && term.result == 0){
+                        // Stopped by this rank: tell the others without waiting for the workers
+                        termSignal(&term, stop_value);
+                    }
+
+                    long rank_tested;
+                    #pragma omp atomic read
+                    rank_tested = keys_tested;
+                    progressPoll(&progress, rank_tested);
+                    progressReport(&progress);
+                    traceSpan(&trace, thread_id, TRACE_POLL, poll_start, 0, 0);
+                    nanosleep(&pause, NULL);
                 }
+                continue;
+            }
+
+            // Threads take blocks of the range as they go, so a thread slowed down by
+            // SMT or a noisy neighbour just ends up with fewer blocks. A shared
+            // counter rather than omp for: once the key is found every thread
+            // stops at its next block, without depending on OMP_CANCELLATION
+            long nblocks = (chunk_upper - chunk_lower + THREAD_BLOCK_KEYS - 1) / THREAD_BLOCK_KEYS;
+            if(counting){
+                perfStart(&perf);
             }
+            for(;;){
+                long b;
+                #pragma omp atomic capture
+                b = next_block++;
+
+                long stop_value;
+                #pragma omp atomic read
+                stop_value = search_stop.value;
+                if(b >= nblocks || stop_value != 0){
+                    break;
+                }
+
+                long block_lower = chunk_lower + b * THREAD_BLOCK_KEYS;
+                long block_upper = (chunk_upper - block_lower > THREAD_BLOCK_KEYS) ?
+                                   block_lower + THREAD_BLOCK_KEYS : chunk_upper;
+
+                long step = 1;
+                long i;
+                double block_start = traceNow(&trace);
+                for(i = block_lower; i < block_upper; i += step){
+                    // Check if the search was stopped by any thread or process
+                    if(thread_keys >= next_stop_check){
+                        next_stop_check = thread_keys + STOP_CHECK_KEYS;
+                        #pragma omp atomic read
+                        stop_value = search_stop.value;
+                        if(stop_value != 0){
+                            break;
+                        }
+                    }
+
+                    // Check if key was found by another process (only master thread checks MPI)
+                    if(polls_mpi && thread_keys >= next_poll){
+                        next_poll = thread_keys + 10000;
+                        double poll_start = traceNow(&trace);
+                        if(id == 0){
+                            schedServe(&sched);
+                        }
+                        if(opts.checkpoint && time(NULL) >= next_checkpoint){
+                            next_checkpoint = time(NULL) + opts.checkpoint_every;
+                            #pragma omp critical(checkpoint)
+                            saveCheckpoint(&opts, id, checkpoint_tag, &searched);
+                        }
+                        long rank_tested;
+                        #pragma omp atomic read
+                        rank_tested = keys_tested;
+                        progressPoll(&progress, rank_tested);
+                        // SIGTERM (e.g. job preemption): stop every rank, each one
+                        // saves its final checkpoint on the way out
+                        stop_value = search_interrupted ? SEARCH_INTERRUPTED : termPoll(&term);
+                        traceSpan(&trace, thread_id, TRACE_POLL, poll_start, 0, 0);
+                        if(stop_value != 0){
+                            traceInstant(&trace, thread_id, TRACE_STOP, stop_value);
+                            #pragma omp critical
+                            {
+                                if(found == 0){
+                                    found = stop_value;
+                                    if(stop_value == SEARCH_INTERRUPTED){
+                                        printf("[Process %d] Interrupted, stopping the search\n", id);
+                                    }
+                                }
+                                #pragma omp atomic write
+                                search_stop.value = found;
+                            }
+                            break;
+                        }
+                    }
 
-            // Try current key
-            if(tryKey(i, cipher, ciphlen, search)){
-                #pragma omp critical
-                {
-                    if(found == 0){
-                        found = i;
-                        printf("[Process %d, Thread %d] KEY FOUND: %ld\n", id, thread_id, found);
-                        // Notify all MPI processes that key was found
-                        for(int node=0; node<N; node++){
-                            MPI_Send(&found, 1, MPI_LONG, node, 0, comm);
+                    // Try current key, or the batch of keys starting at it
+                    long hit;
+                    step = tryKeysEngine(&engine, &bs_work, i, block_upper, &hit);
+
+                    if(hit >= 0){
+                        traceInstant(&trace, thread_id, TRACE_FOUND, hit);
+                    }
+                    if(hit >= 0 && opts.bench > 0){
+                        // No early exit: matches are only counted
+                        #pragma omp atomic
+                        hits++;
+                    } else if(hit >= 0){
+                        #pragma omp critical
+                        {
+                            if(found == 0){
+                                found = TERM_KEY(hit);
+                                printf("[Process %d, Thread %d] KEY FOUND: %ld\n", id, thread_id, hit);
+                            }
+                            #pragma omp atomic write
+                            search_stop.value = found;
                         }
+                        break;
+                    }
+                    local_keys_tested += step;
+                    thread_keys += step;
+
+                    // Update the rank's counter periodically; the MPI thread sums it
+                    // across ranks for the progress reports
+                    if(local_keys_tested >= 100000){
+                        #pragma omp atomic
+                        keys_tested += local_keys_tested;
+                        local_keys_tested = 0;
                     }
                 }
-                break;
-            }
-            local_keys_tested++;
 
-            // Update global counter periodically to track progress
-            if(local_keys_tested % 100000 == 0){
+                traceSpan(&trace, thread_id, TRACE_BLOCK, block_start, block_lower, i);
+                if(polls_mpi){
+                    // Progress completed by the polls above is printed between blocks
+                    progressReport(&progress);
+                }
+
+                // Only whole blocks are recorded: an interrupted block is searched again
+                if(opts.checkpoint && i >= block_upper){
+                    int ok;
+                    #pragma omp critical(checkpoint)
+                    ok = intervalAdd(&searched, block_lower, block_upper);
+                    if(!ok){
+                        // Stop every thread; the master aborts after the search
+                        printf("Error: Cannot record searched keys\n");
+                        #pragma omp atomic write
+                        search_failed = 1;
+                        #pragma omp atomic write
+                        search_stop.value = SEARCH_FAILED;
+                        break;
+                    }
+                }
+            }
+            if(counting){
+                perfPause(&perf);
+            }
+            if(opts.comm_thread){
                 #pragma omp atomic
-                keys_tested += 100000;
-                local_keys_tested = 0;
+                workers_done++;
             }
+        }
 
-            // Print progress updates (only master thread)
-            if(thread_id == 0 && i % 1000000 == 0 && i > thread_lower){
-                double elapsed = difftime(time(NULL), start_time);
-                if(elapsed > 0){
-                    long total_tested;
-                    #pragma omp atomic read
-                    total_tested = keys_tested;
-                    printf("[Process %d] Progress: %ld keys tested (%.2f keys/sec)\n",
-                           id, total_tested, total_tested/elapsed);
+        if(counting){
+            double values[PERF_NCOUNTERS];
+            perfStop(&perf, values);
+            perfClose(&perf);
+            #pragma omp critical(perf)
+            {
+                for(int c = 0; c < PERF_NCOUNTERS; c++){
+                    if(values[c] < 0){
+                        perf_available[c] = 0;
+                    } else {
+                        perf_totals[c] += values[c];
+                    }
+                }
+                if(perf_error == 0){
+                    perf_error = perf.error;
                 }
             }
         }
@@ -453,33 +1823,182 @@ int main(int argc, char *argv[]){
         // Add remaining keys to global counter
         #pragma omp atomic
         keys_tested += local_keys_tested;
+        if(thread_id >= opts.comm_thread){
+            thread_rates[thread_id - opts.comm_thread] = thread_keys / (omp_get_wtime() - thread_start);
+        }
+
+        if(opts.engine == ENGINE_BITSLICE){
+            bsFreeWork(&bs_work);
+        }
+    }
+    if(search_failed){
+        MPI_Abort(comm, 1);
     }
 
-    if(!flag){
-        MPI_Cancel(&req);
-        MPI_Wait(&req, &st);
+    phaseEnd(&timer, PHASE_SEARCH);
+    double finalize_start = traceNow(&trace);
+
+    // The threads have stopped: publish a local find (or SIGTERM) to every rank.
+    // If several ranks found candidates, the first to reach the slot wins
+    if(found != 0){
+        found = termSignal(&term, found);
     }
 
-    if(id == 0){
-        if(!flag){
-            MPI_Wait(&req, &st);
-        }
-        time_t end_time = time(NULL);
+    if(opts.engine == ENGINE_BITSLICE){
+        bsFreeContext(&bs_ctx);
+    }
+    acFree(&ac);
+    if(opts.checkpoint){
+        saveCheckpoint(&opts, id, checkpoint_tag, &searched);
+        intervalFree(&searched);
+        intervalFree(&resumed);
+    }
 
+    double stop_latency;
+    found = termFinish(&term, &stop_latency);
+    // Every rank has stopped: no chunk request can be sent anymore
+    schedFinish(&sched);
+    long key = (found > 0) ? TERM_KEY_OF(found) : -1;
+    progressFinish(&progress, comm, keys_tested);
+    traceSpan(&trace, 0, TRACE_FINALIZE, finalize_start, found, 0);
+    phaseEnd(&timer, PHASE_STOP);
+    unsigned char decrypted[ciphlen + 1];
+    decrypted[0] = 0;
+
+    if(id == 0 && opts.bench == 0){
         printf("\n=== Results ===\n");
         if(found > 0){
-            unsigned char decrypted[ciphlen+1];
-            decrypt(found, cipher, ciphlen, decrypted);
+            decrypt(key, cipher, ciphlen, decrypted);
             decrypted[ciphlen] = 0;
 
             printf("SUCCESS!\n");
-            printf("Key found: %ld\n", found);
+            printf("Key found: %ld\n", key);
             printf("Decrypted text: %s\n", decrypted);
-            printf("Time elapsed: %.2f seconds\n", difftime(end_time, start_time));
+            printf("Time elapsed: %.6f seconds\n", timer.phase[PHASE_SEARCH] + timer.phase[PHASE_STOP]);
+            printf("Stop latency: %.3f ms (until the last process stopped)\n", 1e3 * stop_latency);
+        } else if(found == SEARCH_INTERRUPTED){
+            printf("INTERRUPTED - Progress saved to %s.*, continue with --resume\n", opts.checkpoint);
         } else {
             printf("FAILED - Key not found in search space\n");
         }
     }
+    phaseEnd(&timer, PHASE_VERIFY);
+
+    RunResult result;
+    long total_tested;
+    phaseReduce(&timer, result.phase, comm);
+    MPI_Reduce(&keys_tested, &total_tested, 1, MPI_LONG, MPI_SUM, 0, comm);
+    if(id == 0){
+        printf("Phases (slowest process): setup %.6f s, broadcast %.6f s, search %.6f s, "
+               "stop %.6f s, verify %.6f s\n",
+               result.phase[PHASE_SETUP], result.phase[PHASE_BCAST], result.phase[PHASE_SEARCH],
+               result.phase[PHASE_STOP], result.phase[PHASE_VERIFY]);
+    }
+
+    if(opts.bench > 0){
+        // Slowest and fastest process and thread, and the mean thread rate
+        double rank_rate = keys_tested / timer.phase[PHASE_SEARCH];
+        double low[2] = { rank_rate, thread_rates[0] }, high[2] = { rank_rate, thread_rates[0] }, sum = 0;
+        for(int t = 0; t < num_threads; t++){
+            if(thread_rates[t] < low[1]) low[1] = thread_rates[t];
+            if(thread_rates[t] > high[1]) high[1] = thread_rates[t];
+            sum += thread_rates[t];
+        }
+        double rank_low[2], rank_high[2], thread_sum;
+        long total_hits;
+        MPI_Reduce(low, rank_low, 2, MPI_DOUBLE, MPI_MIN, 0, comm);
+        MPI_Reduce(high, rank_high, 2, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(&sum, &thread_sum, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+        MPI_Reduce(&hits, &total_hits, 1, MPI_LONG, MPI_SUM, 0, comm);
+
+        if(id == 0){
+            BenchResult bench;
+            bench.program = "program_parallel";
+            bench.input = argv[1];
+            bench.engine = (opts.engine == ENGINE_BITSLICE) ? "bitslice" :
+                           (opts.engine == ENGINE_SPTABLE) ? "sptable" : "openssl";
+            bench.schedule = (opts.chunk > 0) ? "dynamic" : opts.calibrate ? "calibrated" : "static";
+            bench.chunk = opts.chunk;
+            bench.processes = N;
+            bench.threads = num_threads;
+            bench.window = upper;
+            bench.keys_tested = total_tested;
+            bench.hits = total_hits;
+            bench.time_search = result.phase[PHASE_SEARCH];
+            bench.rate = total_tested / bench.time_search;
+            bench.rank_min = rank_low[0];
+            bench.rank_max = rank_high[0];
+            bench.thread_min = rank_low[1];
+            bench.thread_mean = thread_sum / ((double)N * num_threads);
+            bench.thread_max = rank_high[1];
+            bench.serial = serial_rate;
+            bench.speedup = bench.rate / serial_rate;
+            bench.efficiency = bench.speedup / ((double)N * num_threads);
+
+            printf("\n=== Benchmark ===\n");
+            printf("Keys tested: %ld of a %ld-key window (%ld matches, no early exit)\n",
+                   bench.keys_tested, bench.window, bench.hits);
+            printf("Search time (slowest process): %.6f s\n", bench.time_search);
+            printf("Keys/sec: %.0f total, %.0f to %.0f per process, %.0f to %.0f per thread (mean %.0f)\n",
+                   bench.rate, bench.rank_min, bench.rank_max, bench.thread_min, bench.thread_max, bench.thread_mean);
+            printf("Speedup: %.3f over the serial baseline, efficiency %.1f%% (%d processes x %d threads)\n",
+                   bench.speedup, 100 * bench.efficiency, N, num_threads);
+            if(!benchWrite(opts.bench_out, &bench)){
+                printf("Warning: Cannot write the benchmark row to %s\n", opts.bench_out);
+            }
+        }
+    }
+
+    if(opts.perf){
+        // An event counts only if every thread of every rank could count it
+        double events[PERF_NCOUNTERS];
+        int available[PERF_NCOUNTERS];
+        MPI_Reduce(perf_totals, events, PERF_NCOUNTERS, MPI_DOUBLE, MPI_SUM, 0, comm);
+        MPI_Reduce(perf_available, available, PERF_NCOUNTERS, MPI_INT, MPI_MIN, 0, comm);
+        if(id == 0){
+            printf("Hardware counters per key tested (%ld keys, all threads of all processes):\n", total_tested);
+            for(int c = 0; c < PERF_NCOUNTERS; c++){
+                if(!available[c]){
+                    printf("  %-16s unavailable\n", perf_names[c]);
+                } else if(c == PERF_INSTRUCTIONS && available[PERF_CYCLES] && events[PERF_CYCLES] > 0){
+                    printf("  %-16s %.3f (IPC %.2f)\n", perf_names[c], events[c] / total_tested,
+                           events[c] / events[PERF_CYCLES]);
+                } else {
+                    printf("  %-16s %.3f\n", perf_names[c], events[c] / total_tested);
+                }
+            }
+            if(perf_error != 0){
+                printf("  (perf_event_open on rank 0: %s)\n", strerror(perf_error));
+            }
+        }
+    }
+
+    if(id == 0){
+        if(opts.results){
+            result.program = "program_parallel";
+            result.input = argv[1];
+            result.search = search;
+            result.processes = N;
+            result.threads = num_threads;
+            result.engine = (opts.engine == ENGINE_BITSLICE) ? "bitslice" :
+                            (opts.engine == ENGINE_SPTABLE) ? "sptable" : "openssl";
+            result.schedule = (opts.chunk > 0) ? "dynamic" : opts.calibrate ? "calibrated" : "static";
+            result.chunk = opts.chunk;
+            result.keyspace = upper;
+            result.status = (opts.bench > 0) ? "bench" : (found > 0) ? "found" :
+                            (found == SEARCH_INTERRUPTED) ? "interrupted" : "not_found";
+            result.key = key;
+            result.plaintext = (const char *)decrypted;
+            result.keys_tested = total_tested;
+            result.total = MPI_Wtime() - timer.start;
+            result.stop_latency = stop_latency;
+            if(!resultsWrite(opts.results, &result)){
+                printf("Warning: Cannot write results to %s\n", opts.results);
+            }
+        }
+    }
+
+    traceWrite(&trace, comm, opts.trace);
 
     free(cipher);
     if(search) free(search);
@@ -0,0 +1,157 @@
+/**
+ * @file progress.h
+ * @brief Global search progress: keys/sec, keyspace covered and ETA across all ranks
+ *
+ * At a fixed time interval every rank contributes its count of tested keys
+ * to an MPI_Iallreduce, and rank 0 prints the global rate, the fraction of
+ * the keyspace covered and the estimated time left once the reduction
+ * completes. Polling only records a completed reduction; the caller prints
+ * it with progressReport where output cannot stall its search loop, e.g.
+ * between blocks of keys. A new reduction starts only after the previous one has
+ * completed, so ranks never block on each other: a slow rank just makes
+ * reports less frequent, and reports stop once a rank is done searching.
+ *
+ * Reductions run on a duplicate of the search communicator, so they never
+ * match a collective of the search itself. Ranks may have started
+ * different numbers of them when the search ends; progressFinish starts the
+ * missing ones so every reduction completes.
+ *
+ * Only the thread that owns MPI may call these functions.
+ */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <stdio.h>
+#include <mpi.h>
+
+/**
+ * @brief Progress reporting state of one rank
+ */
+typedef struct {
+    MPI_Comm comm;       /**< Duplicate of the search communicator */
+    int rank;
+    double interval;     /**< Seconds between reductions */
+    double start;        /**< MPI_Wtime when the search started */
+    double next;         /**< MPI_Wtime of the next reduction */
+    double sent;         /**< MPI_Wtime when the reduction in flight started */
+    long keyspace;       /**< Keys of the whole search */
+    long done_before;    /**< Keys searched by previous runs (resumed checkpoints) */
+    long send;           /**< This rank's keys tested, as sent */
+    long total;          /**< Keys tested by all ranks, as received */
+    MPI_Request req;     /**< Reduction in flight, or MPI_REQUEST_NULL */
+    int started;         /**< Reductions started by this rank */
+    int pending;         /**< Rank 0: nonzero if a completed reduction is not printed yet */
+} ProgressReporter;
+
+/**
+ * @brief Sets up progress reporting (collective)
+ *
+ * @param p Reporter to initialize
+ * @param comm Communicator of the search
+ * @param interval Seconds between reports
+ * @param keyspace Keys of the whole search
+ * @param done_before Keys already searched by previous runs
+ */
+static void progressInit(ProgressReporter *p, MPI_Comm comm, double interval, long keyspace, long done_before){
+    MPI_Comm_dup(comm, &p->comm);
+    MPI_Comm_rank(comm, &p->rank);
+    p->interval = interval;
+    p->start = MPI_Wtime();
+    p->next = p->start + interval;
+    p->sent = p->start;
+    p->keyspace = keyspace;
+    p->done_before = done_before;
+    p->send = p->total = 0;
+    p->req = MPI_REQUEST_NULL;
+    p->started = 0;
+    p->pending = 0;
+}
+
+/**
+ * @brief Formats a duration as days, hours, minutes and seconds
+ */
+static void progressFormatTime(double seconds, char *buf, size_t len){
+    if(seconds > 1e4 * 365 * 86400){
+        snprintf(buf, len, "> 10000 years");
+    } else if(seconds >= 365 * 86400){
+        snprintf(buf, len, "%.1f years", seconds / (365 * 86400));
+    } else {
+        long s = (long)seconds;
+        snprintf(buf, len, "%ldd %02ldh %02ldm %02lds", s / 86400, s / 3600 % 24, s / 60 % 60, s % 60);
+    }
+}
+
+/**
+ * @brief Rank 0: prints the global progress of the last completed reduction, once
+ *
+ * Does nothing on other ranks or when there is nothing new to print.
+ */
+static void progressReport(ProgressReporter *p){
+    if(!p->pending){
+        return;
+    }
+    p->pending = 0;
+    double elapsed = p->sent - p->start;
+    double rate = (elapsed > 0) ? p->total / elapsed : 0;
+    long covered = p->done_before + p->total;
+    char eta[64];
+    if(rate > 0){
+        progressFormatTime((p->keyspace - covered) / rate, eta, sizeof(eta));
+    } else {
+        snprintf(eta, sizeof(eta), "unknown");
+    }
+    printf("Progress: %ld keys tested (%.3g%% of the keyspace), %.0f keys/sec, ETA %s\n",
+           p->total, 100.0 * covered / p->keyspace, rate, eta);
+    fflush(stdout);
+}
+
+/**
+ * @brief Completes the reduction in flight and starts one when the interval has elapsed
+ *
+ * Called from the polling points; never blocks and never prints (see
+ * progressReport).
+ *
+ * @param p Reporter
+ * @param keys Keys tested by this rank so far
+ */
+static void progressPoll(ProgressReporter *p, long keys){
+    double now = MPI_Wtime();
+    if(p->req != MPI_REQUEST_NULL){
+        int done;
+        MPI_Test(&p->req, &done, MPI_STATUS_IGNORE);
+        if(!done){
+            return;
+        }
+        p->pending = (p->rank == 0);
+    }
+    if(now >= p->next){
+        p->send = keys;
+        MPI_Iallreduce(&p->send, &p->total, 1, MPI_LONG, MPI_SUM, p->comm, &p->req);
+        p->started++;
+        p->sent = now;
+        p->next = now + p->interval;
+    }
+}
+
+/**
+ * @brief Completes every rank's reductions and releases the communicator (collective)
+ *
+ * @param p Reporter
+ * @param comm Communicator of the search, to agree on the number of reductions
+ * @param keys Keys tested by this rank
+ */
+static void progressFinish(ProgressReporter *p, MPI_Comm comm, long keys){
+    int most;
+    MPI_Allreduce(&p->started, &most, 1, MPI_INT, MPI_MAX, comm);
+    MPI_Wait(&p->req, MPI_STATUS_IGNORE);
+    p->send = keys;
+    // Nonblocking collectives only match nonblocking ones
+    for(; p->started < most; p->started++){
+        MPI_Iallreduce(&p->send, &p->total, 1, MPI_LONG, MPI_SUM, p->comm, &p->req);
+        MPI_Wait(&p->req, MPI_STATUS_IGNORE);
+    }
+    MPI_Comm_free(&p->comm);
+}
+
+#endif /* PROGRESS_H */
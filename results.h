@@ -0,0 +1,236 @@
+/**
+ * @file results.h
+ * @brief Phase timing with MPI_Wtime and machine-readable result records
+ *
+ * A run is split into phases (setup, broadcast, search, stop propagation,
+ * verify) timed with MPI_Wtime, so short runs are measured to the
+ * microsecond instead of whole seconds. Each rank times its own phases;
+ * the record written by rank 0 holds the slowest rank's time of each phase.
+ *
+ * Records are appended to a file: one JSON object per line if its name
+ * ends in .json, otherwise one CSV row, with the header written when the
+ * file is new. Benchmark scripts read these instead of parsing the
+ * console output.
+ *
+ * A --bench run writes a different row, always CSV: the throughput of a
+ * fixed keyspace window with its speedup over a serial baseline.
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+
+/** Phases of a brute-force run */
+enum { PHASE_SETUP, PHASE_BCAST, PHASE_SEARCH, PHASE_STOP, PHASE_VERIFY, PHASE_COUNT };
+
+/** Names of the phases, as used in the records */
+static const char *const phase_names[PHASE_COUNT] = { "setup", "bcast", "search", "stop", "verify" };
+
+/**
+ * @brief Time spent by one rank in each phase
+ */
+typedef struct {
+    double start;               /**< MPI_Wtime when the run started */
+    double last;                /**< MPI_Wtime when the last phase ended */
+    double phase[PHASE_COUNT];  /**< Seconds spent in each phase */
+} PhaseTimer;
+
+/**
+ * @brief Starts timing a run (call right after MPI_Init)
+ */
+static inline void phaseInit(PhaseTimer *t){
+    t->start = t->last = MPI_Wtime();
+    for(int p = 0; p < PHASE_COUNT; p++){
+        t->phase[p] = 0;
+    }
+}
+
+/**
+ * @brief Ends the current phase: the time since the previous call is added to phase
+ *
+ * A phase may be ended several times; its times add up.
+ */
+static inline void phaseEnd(PhaseTimer *t, int phase){
+    double now = MPI_Wtime();
+    t->phase[phase] += now - t->last;
+    t->last = now;
+}
+
+/**
+ * @brief Everything a result record holds
+ */
+typedef struct {
+    const char *program;   /**< Program name */
+    const char *input;     /**< Encrypted file */
+    const char *search;    /**< Search string */
+    int processes;         /**< MPI ranks */
+    int threads;           /**< Searching threads per rank */
+    const char *engine;    /**< Key testing backend */
+    const char *schedule;  /**< static, calibrated or dynamic */
+    long chunk;            /**< Keys per dynamic chunk, 0 if static */
+    long keyspace;         /**< Keys to enumerate */
+    const char *status;    /**< found, not_found, interrupted or bench */
+    long key;              /**< Found key, or -1 */
+    const char *plaintext; /**< Text decrypted with the found key, empty if none */
+    long keys_tested;      /**< Keys tested by all ranks */
+    double phase[PHASE_COUNT]; /**< Slowest rank's seconds in each phase */
+    double total;          /**< Seconds from start to end of the run on rank 0 */
+    double stop_latency;   /**< Seconds from the first signal to the last rank stopping, or -1 */
+} RunResult;
+
+/**
+ * @brief Collects the slowest rank's phase times on rank 0 (collective)
+ */
+static inline void phaseReduce(const PhaseTimer *t, double out[PHASE_COUNT], MPI_Comm comm){
+    MPI_Reduce(t->phase, out, PHASE_COUNT, MPI_DOUBLE, MPI_MAX, 0, comm);
+}
+
+/**
+ * @brief Writes a string as a JSON string literal
+ */
+static inline void resultsJsonString(FILE *file, const char *s){
+    fputc('"', file);
+    for(; *s; s++){
+        unsigned char c = (unsigned char)*s;
+        if(c == '"' || c == '\\'){
+            fprintf(file, "\\%c", c);
+        } else if(c < 0x20){
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+/**
+ * @brief Writes a string as a CSV field, quoted
+ */
+static inline void resultsCsvString(FILE *file, const char *s){
+    fputc('"', file);
+    for(; *s; s++){
+        if(*s == '"'){
+            fputc('"', file);
+        }
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+/**
+ * @brief Appends a record to a results file
+ *
+ * @param path File name; .json gives JSON Lines, anything else CSV
+ * @param r Record to write
+ * @return 1 on success, 0 if the file cannot be written
+ */
+static inline int resultsWrite(const char *path, const RunResult *r){
+    size_t len = strlen(path);
+    int json = (len >= 5 && strcmp(path + len - 5, ".json") == 0);
+    double rate = (r->phase[PHASE_SEARCH] > 0) ? r->keys_tested / r->phase[PHASE_SEARCH] : 0;
+
+    FILE *file = fopen(path, "a");
+    if(!file){
+        return 0;
+    }
+    if(json){
+        fprintf(file, "{\"program\":");
+        resultsJsonString(file, r->program);
+        fprintf(file, ",\"input\":");
+        resultsJsonString(file, r->input);
+        fprintf(file, ",\"search\":");
+        resultsJsonString(file, r->search);
+        fprintf(file, ",\"processes\":%d,\"threads\":%d,\"engine\":\"%s\",\"schedule\":\"%s\",\"chunk\":%ld",
+                r->processes, r->threads, r->engine, r->schedule, r->chunk);
+        fprintf(file, ",\"keyspace\":%ld,\"status\":\"%s\",\"key\":%ld,\"plaintext\":",
+                r->keyspace, r->status, r->key);
+        resultsJsonString(file, r->plaintext);
+        fprintf(file, ",\"keys_tested\":%ld", r->keys_tested);
+        for(int p = 0; p < PHASE_COUNT; p++){
+            fprintf(file, ",\"time_%s\":%.6f", phase_names[p], r->phase[p]);
+        }
+        fprintf(file, ",\"time_total\":%.6f,\"keys_per_sec\":%.0f,\"stop_latency_ms\":%.3f}\n",
+                r->total, rate, (r->stop_latency >= 0) ? 1e3 * r->stop_latency : -1.0);
+    } else {
+        // Header only for a new (empty) file
+        fseek(file, 0, SEEK_END);
+        if(ftell(file) == 0){
+            fprintf(file, "program,input,search,processes,threads,engine,schedule,chunk,keyspace,status,key,"
+                          "plaintext,keys_tested");
+            for(int p = 0; p < PHASE_COUNT; p++){
+                fprintf(file, ",time_%s", phase_names[p]);
+            }
+            fprintf(file, ",time_total,keys_per_sec,stop_latency_ms\n");
+        }
+        fprintf(file, "%s,", r->program);
+        resultsCsvString(file, r->input);
+        fputc(',', file);
+        resultsCsvString(file, r->search);
+        fprintf(file, ",%d,%d,%s,%s,%ld,%ld,%s,%ld,",
+                r->processes, r->threads, r->engine, r->schedule, r->chunk,
+                r->keyspace, r->status, r->key);
+        resultsCsvString(file, r->plaintext);
+        fprintf(file, ",%ld", r->keys_tested);
+        for(int p = 0; p < PHASE_COUNT; p++){
+            fprintf(file, ",%.6f", r->phase[p]);
+        }
+        fprintf(file, ",%.6f,%.0f,%.3f\n", r->total, rate, (r->stop_latency >= 0) ? 1e3 * r->stop_latency : -1.0);
+    }
+    return fclose(file) == 0;
+}
+
+/**
+ * @brief Throughput of a benchmark sweep (--bench)
+ */
+typedef struct {
+    const char *program;   /**< Program name */
+    const char *input;     /**< Encrypted file */
+    const char *engine;    /**< Key testing backend */
+    const char *schedule;  /**< static, calibrated or dynamic */
+    long chunk;            /**< Keys per dynamic chunk, 0 if static */
+    int processes;         /**< MPI ranks */
+    int threads;           /**< Searching threads per rank */
+    long window;           /**< Keys of the window */
+    long keys_tested;      /**< Keys tested by all ranks */
+    long hits;             /**< Matching keys met in the window */
+    double time_search;    /**< Slowest rank's search seconds */
+    double rate;           /**< Keys/sec of the whole run */
+    double rank_min;       /**< Keys/sec of the slowest rank */
+    double rank_max;       /**< Keys/sec of the fastest rank */
+    double thread_min;     /**< Keys/sec of the slowest thread */
+    double thread_mean;    /**< Mean keys/sec of a thread */
+    double thread_max;     /**< Keys/sec of the fastest thread */
+    double serial;         /**< Keys/sec of one thread alone */
+    double speedup;        /**< rate / serial */
+    double efficiency;     /**< speedup / (processes * threads) */
+} BenchResult;
+
+/**
+ * @brief Appends a benchmark row to a CSV file, with the header if the file is new
+ *
+ * @return 1 on success, 0 if the file cannot be written
+ */
+static inline int benchWrite(const char *path, const BenchResult *b){
+    FILE *file = fopen(path, "a");
+    if(!file){
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    if(ftell(file) == 0){
+        fprintf(file, "program,input,engine,schedule,chunk,processes,threads,window,keys_tested,hits,"
+                      "time_search,keys_per_sec,rank_min,rank_max,thread_min,thread_mean,thread_max,"
+                      "serial_keys_per_sec,speedup,efficiency\n");
+    }
+    fprintf(file, "%s,", b->program);
+    resultsCsvString(file, b->input);
+    fprintf(file, ",%s,%s,%ld,%d,%d,%ld,%ld,%ld,%.6f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.4f,%.4f\n",
+            b->engine, b->schedule, b->chunk, b->processes, b->threads, b->window, b->keys_tested, b->hits,
+            b->time_search, b->rate, b->rank_min, b->rank_max, b->thread_min, b->thread_mean, b->thread_max,
+            b->serial, b->speedup, b->efficiency);
+    return fclose(file) == 0;
+}
+
+#endif /* RESULTS_H */
@@ -1,7 +1,7 @@
 #!/bin/bash
 
 echo "=== Compilando versión paralela (MPI + OpenMP) ==="
-mpicc -fopenmp -o program_parallel program_parallel.c -lssl -lcrypto
+mpicc -O2 -fopenmp -o program_parallel program_parallel.c -lssl -lcrypto
 
 if [ $? -eq 0 ]; then
     echo "Compilación exitosa"
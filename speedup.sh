@@ -20,52 +20,46 @@ RESULTS_FILE="resultados_comparacion.txt"
 # Limpiar archivo anterior
 > "$RESULTS_FILE"
 
+# Lee el registro JSON escrito con --results: tiempo (búsqueda + parada),
+# texto desencriptado y llave
+read_record() {
+    local record=$1
+    
+    if [ ! -f "$record" ]; then
+        echo "||"
+        return
+    fi
+    
+    tiempo=$(awk -v s="$(grep -oP '"time_search":\K[0-9.]+' "$record")" \
+                 -v p="$(grep -oP '"time_stop":\K[0-9.]+' "$record")" 'BEGIN { printf "%.6f", s + p }')
+    decrypted=$(grep -oP '"plaintext":"\K(\\.|[^"\\])*' "$record")
+    key=$(grep -oP '"key":\K\d+' "$record")
+    
+    echo "$tiempo|$decrypted|$key"
+}
+
 # Función para ejecutar versión normal y extraer información
 run_normal() {
     local file=$1
     local text=$2
+    local record="registro_normal.json"
     
-    # Ejecutar y capturar salida completa
-    output=$(mpirun -np "$NUM_PROCS" ./main "$file" "$text" 2>&1)
-    
-    # Extraer tiempo
-    tiempo=$(echo "$output" | grep -iE "(time|tiempo|elapsed)" | grep -oP '\d+\.\d+' | head -1)
-    
-    if [ -z "$tiempo" ]; then
-        tiempo=$(echo "$output" | grep -oP '\d+\.\d+' | head -1)
-    fi
-    
-    # Extraer texto desencriptado
-    decrypted=$(echo "$output" | grep -i "Decrypted text:" | sed 's/.*Decrypted text: //')
-    
-    # Extraer llave encontrada
-    key=$(echo "$output" | grep -i "Key found:" | grep -oP '\d+' | head -1)
-    
-    echo "$tiempo|$decrypted|$key"
+    rm -f "$record"
+    mpirun -np "$NUM_PROCS" ./main "$file" "$text" --results "$record" > /dev/null 2>&1
+    read_record "$record"
+    rm -f "$record"
 }
 
 # Función para ejecutar versión paralela optimizada y extraer información
 run_parallel() {
     local file=$1
     local text=$2
+    local record="registro_parallel.json"
     
-    # Ejecutar y capturar salida completa
-    output=$(mpirun -np "$NUM_PROCS" ./main_parallel "$file" "$text" 2>&1)
-    
-    # Extraer tiempo
-    tiempo=$(echo "$output" | grep -iE "(time|tiempo|elapsed)" | grep -oP '\d+\.\d+' | head -1)
-    
-    if [ -z "$tiempo" ]; then
-        tiempo=$(echo "$output" | grep -oP '\d+\.\d+' | head -1)
-    fi
-    
-    # Extraer texto desencriptado
-    decrypted=$(echo "$output" | grep -i "Decrypted text:" | sed 's/.*Decrypted text: //')
-    
-    # Extraer llave encontrada
-    key=$(echo "$output" | grep -i "Key found:" | grep -oP '\d+' | head -1)
-    
-    echo "$tiempo|$decrypted|$key"
+    rm -f "$record"
+    mpirun -np "$NUM_PROCS" ./main_parallel "$file" "$text" --results "$record" > /dev/null 2>&1
+    read_record "$record"
+    rm -f "$record"
 }
 
 # Función para calcular promedio
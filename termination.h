@@ -0,0 +1,259 @@
+/**
+ * @file termination.h
+ * @brief Cross-rank stop signal: a shared-memory slot per node and a one-sided result slot
+ *
+ * The ranks of each node (MPI_Comm_split_type with MPI_COMM_TYPE_SHARED)
+ * share a stop slot in an MPI_Win_allocate_shared window: 0 while the
+ * search runs, then the found key plus one (TERM_KEY, so key 0 can be
+ * reported) or a negative stop code. Stopping the
+ * node is a single compare-and-swap on that memory, and polling it is a
+ * single load, with no MPI call at all.
+ *
+ * Only the lowest rank of each node, its leader, talks to the other nodes.
+ * Rank 0 exposes the global result slot in an RMA window; a leader
+ * publishes the stop value of its node there with one MPI_Compare_and_swap,
+ * so when several nodes find candidates at once exactly one of them wins
+ * and every rank agrees on the result. Leaders poll that slot with
+ * MPI_Fetch_and_op (MPI_NO_OP) and copy a stop value into their node slot.
+ *
+ * The stop latency is measured: each rank records when it signalled or
+ * first saw the stop, relative to a common barrier at startup, and
+ * termFinish reports the delay between the first signal and the slowest
+ * rank noticing it.
+ *
+ * Both windows stay locked (MPI_Win_lock_all) for the whole search; only
+ * one thread per rank may call these functions.
+ */
+
+#ifndef TERMINATION_H
+#define TERMINATION_H
+
+#include <mpi.h>
+#include <time.h>
+
+/** Pause of a node leader between two polls while waiting for its node, in nanoseconds */
+#define TERM_WAIT_NS 100000
+
+/** Stop value of a found key: never 0, so key 0 can be reported */
+#define TERM_KEY(key) ((key) + 1)
+
+/** Key of a positive stop value made with TERM_KEY */
+#define TERM_KEY_OF(value) ((value) - 1)
+
+/**
+ * @brief Slot shared by the ranks of one node
+ */
+typedef struct {
+    long stop;            /**< Stop value of the node, 0 while running */
+    long done;            /**< Ranks other than the leader that reached termFinish */
+} TermNodeSlot;
+
+/**
+ * @brief Stop state of one rank
+ */
+typedef struct {
+    MPI_Comm comm;
+    int rank;
+    MPI_Comm node_comm;   /**< Ranks sharing memory with this one */
+    int node_size;
+    int leader;           /**< Nonzero on the lowest rank of the node */
+    MPI_Win node_win;     /**< Shared window holding the node slot */
+    TermNodeSlot *node;   /**< Node slot (in shared memory) */
+    MPI_Comm leader_comm; /**< Node leaders (MPI_COMM_NULL on other ranks) */
+    MPI_Win win;          /**< Window exposing the result slot of rank 0 (leaders only) */
+    long *slot;           /**< Result slot (rank 0 only) */
+    long result;          /**< Stop value seen by this rank, 0 while running */
+    double epoch;         /**< MPI_Wtime right after the startup barrier */
+    double signal_time;   /**< When this rank's signal stopped its node, or -1 */
+    double notice_time;   /**< When this rank signalled or first saw the stop, or -1 */
+} Termination;
+
+/**
+ * @brief Creates the node and result windows (collective)
+ *
+ * @param t Termination state to initialize
+ * @param comm Communicator of the search
+ */
+static void termInit(Termination *t, MPI_Comm comm){
+    int node_rank;
+    MPI_Aint size;
+    int disp_unit;
+
+    t->comm = comm;
+    MPI_Comm_rank(comm, &t->rank);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, t->rank, MPI_INFO_NULL, &t->node_comm);
+    MPI_Comm_rank(t->node_comm, &node_rank);
+    MPI_Comm_size(t->node_comm, &t->node_size);
+    t->leader = (node_rank == 0);
+
+    // The leader holds the node slot, the other ranks map it
+    MPI_Win_allocate_shared(t->leader ? sizeof(TermNodeSlot) : 0, 1, MPI_INFO_NULL, t->node_comm,
+                            &t->node, &t->node_win);
+    MPI_Win_shared_query(t->node_win, 0, &size, &disp_unit, &t->node);
+    if(t->leader){
+        t->node->stop = 0;
+        t->node->done = 0;
+    }
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, t->node_win);
+    MPI_Win_sync(t->node_win);
+
+    // Rank 0 has the lowest rank of its node, so it is leader 0
+    MPI_Comm_split(comm, t->leader ? 0 : MPI_UNDEFINED, t->rank, &t->leader_comm);
+    t->win = MPI_WIN_NULL;
+    t->slot = NULL;
+    if(t->leader){
+        MPI_Win_allocate((t->rank == 0) ? sizeof(long) : 0, sizeof(long), MPI_INFO_NULL, t->leader_comm,
+                         &t->slot, &t->win);
+        if(t->rank == 0){
+            *t->slot = 0;
+        }
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, t->win);
+        MPI_Win_sync(t->win);
+    }
+
+    t->result = 0;
+    t->signal_time = -1;
+    t->notice_time = -1;
+    MPI_Barrier(comm);
+    t->epoch = MPI_Wtime();
+}
+
+/**
+ * @brief Sets the node's stop value unless it is already set
+ *
+ * @return The node's stop value after the call
+ */
+static long termNodeStop(Termination *t, long value){
+    long prev = 0;
+    __atomic_compare_exchange_n(&t->node->stop, &prev, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return (prev == 0) ? value : prev;
+}
+
+/**
+ * @brief Leader: publishes the node's stop value in rank 0's result slot unless it is already set
+ *
+ * @return The global stop value after the call
+ */
+static long termGlobalStop(Termination *t, long value){
+    long zero = 0, prev;
+    MPI_Compare_and_swap(&value, &zero, &prev, MPI_LONG, 0, 0, t->win);
+    MPI_Win_flush(0, t->win);
+    return (prev == 0) ? value : prev;
+}
+
+/**
+ * @brief Records the first time this rank sees the search stopped
+ */
+static void termNotice(Termination *t, long value){
+    t->result = value;
+    if(t->notice_time < 0){
+        t->notice_time = MPI_Wtime() - t->epoch;
+    }
+}
+
+/**
+ * @brief Publishes a stop value, unless another rank already did
+ *
+ * On a leader the value also reaches the other nodes right away; on other
+ * ranks the leader forwards it at its next poll.
+ *
+ * @param t Termination state
+ * @param value Found key, or a negative stop code (nonzero)
+ * @return The value that stopped the search as far as this rank can tell:
+ *         value if this call won, else the earlier one (termFinish has the final word)
+ */
+static long termSignal(Termination *t, long value){
+    long stop = termNodeStop(t, value);
+    if(stop == value && t->signal_time < 0){
+        t->signal_time = MPI_Wtime() - t->epoch;
+    }
+    if(t->leader){
+        stop = termGlobalStop(t, stop);
+    }
+    termNotice(t, stop);
+    return stop;
+}
+
+/**
+ * @brief Checks whether the search has been stopped
+ *
+ * A single load of the node slot, plus on leaders one remote read of the
+ * result slot, or forwarding the node's stop value to it.
+ *
+ * @param t Termination state
+ * @return The stop value, or 0 while the search runs
+ */
+static long termPoll(Termination *t){
+    if(t->result != 0){
+        return t->result;
+    }
+    long value = __atomic_load_n(&t->node->stop, __ATOMIC_ACQUIRE);
+    if(t->leader){
+        if(value != 0){
+            // Signalled by another rank of this node
+            value = termGlobalStop(t, value);
+        } else {
+            MPI_Fetch_and_op(NULL, &value, MPI_LONG, 0, 0, MPI_NO_OP, t->win);
+            MPI_Win_flush(0, t->win);
+            if(value != 0){
+                termNodeStop(t, value);
+            }
+        }
+    }
+    if(value != 0){
+        termNotice(t, value);
+    }
+    return value;
+}
+
+/**
+ * @brief Releases the windows and agrees on the result (collective)
+ *
+ * A leader keeps forwarding its node's stop value until every rank of the
+ * node got here, so a key found by a node's last searching rank still
+ * stops the other nodes.
+ *
+ * @param t Termination state
+ * @param latency Pointer to store the stop latency in seconds: the delay
+ *                between the first signal and the last rank noticing the
+ *                stop, or -1 if the search was not stopped by a signal
+ * @return The final stop value, 0 if the search ran to completion
+ */
+static long termFinish(Termination *t, double *latency){
+    long result = 0;
+    if(t->leader){
+        const struct timespec pause = { 0, TERM_WAIT_NS };
+        while(__atomic_load_n(&t->node->done, __ATOMIC_ACQUIRE) < t->node_size - 1){
+            termPoll(t);
+            nanosleep(&pause, NULL);
+        }
+        termPoll(t);
+
+        MPI_Win_unlock_all(t->win);
+        MPI_Barrier(t->leader_comm);
+        if(t->rank == 0){
+            MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, t->win);
+            result = *t->slot;
+            MPI_Win_unlock(0, t->win);
+        }
+    } else {
+        __atomic_add_fetch(&t->node->done, 1, __ATOMIC_RELEASE);
+    }
+    MPI_Bcast(&result, 1, MPI_LONG, 0, t->comm);
+
+    // Earliest signal (negated, so a single MAX reduction) and latest notice
+    double times[2] = { (t->signal_time >= 0) ? -t->signal_time : -1e300, t->notice_time }, last[2];
+    MPI_Allreduce(times, last, 2, MPI_DOUBLE, MPI_MAX, t->comm);
+    *latency = (last[0] > -1e300) ? last[1] + last[0] : -1;
+
+    MPI_Win_unlock_all(t->node_win);
+    MPI_Win_free(&t->node_win);
+    MPI_Comm_free(&t->node_comm);
+    if(t->leader){
+        MPI_Win_free(&t->win);
+        MPI_Comm_free(&t->leader_comm);
+    }
+    return result;
+}
+
+#endif /* TERMINATION_H */
@@ -0,0 +1,290 @@
+/**
+ * @file topology.h
+ * @brief CPU topology probe from sysfs and thread placement
+ *
+ * Reads the online CPUs with their package, core and NUMA node from
+ * /sys/devices/system, the way hwloc discovers them on Linux. The ranks of
+ * a node are spread over its placement domains (NUMA nodes, or packages on
+ * a single-node machine), one rank per domain first; ranks sharing a
+ * domain split its physical cores.
+ *
+ * A rank's CPUs are listed one hardware thread per physical core first,
+ * then the SMT siblings, so thread t pinned to the t-th CPU of the list
+ * gets a core of its own as long as there are cores left.
+ *
+ * Requires _GNU_SOURCE before the first system header (sched_setaffinity).
+ */
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+/** Largest number of CPUs handled (size of a cpu_set_t) */
+#define TOPO_MAX_CPUS CPU_SETSIZE
+
+/** Largest number of SMT siblings per physical core */
+#define TOPO_MAX_SMT 8
+
+/**
+ * @brief One online CPU (hardware thread)
+ */
+typedef struct {
+    int cpu;     /**< OS CPU number */
+    int package; /**< Physical package (socket) */
+    int core;    /**< Core id within the package */
+    int node;    /**< NUMA node */
+} TopoCpu;
+
+/**
+ * @brief Online CPUs of the machine
+ */
+typedef struct {
+    TopoCpu cpus[TOPO_MAX_CPUS]; /**< Online CPUs in increasing order */
+    int ncpus;
+    int ncores;    /**< Physical cores */
+    int npackages; /**< Packages (sockets) */
+    int nnodes;    /**< NUMA nodes */
+    int numa;      /**< Nonzero if the placement domains are NUMA nodes, zero for packages */
+} Topology;
+
+/**
+ * @brief Reads an integer from a sysfs file
+ *
+ * @return The value, or fallback if the file is missing
+ */
+static inline int topoReadInt(const char *path, int fallback){
+    FILE *file = fopen(path, "r");
+    int value;
+    if(!file){
+        return fallback;
+    }
+    if(fscanf(file, "%d", &value) != 1){
+        value = fallback;
+    }
+    fclose(file);
+    return value;
+}
+
+/**
+ * @brief Reads a sysfs CPU list such as "0-3,8-11" into a membership table
+ *
+ * @param path List file
+ * @param member Table of TOPO_MAX_CPUS flags, set for the CPUs of the list
+ * @return 1 on success, 0 if the file is missing or malformed
+ */
+static inline int topoReadList(const char *path, unsigned char *member){
+    FILE *file = fopen(path, "r");
+    int lo, hi, ok = 0;
+    char sep;
+    if(!file){
+        return 0;
+    }
+    while(fscanf(file, "%d", &lo) == 1){
+        hi = lo;
+        sep = 0;
+        if(fscanf(file, "%c", &sep) == 1 && sep == '-'){
+            if(fscanf(file, "%d", &hi) != 1){
+                break;
+            }
+            if(fscanf(file, "%c", &sep) != 1){
+                sep = 0;
+            }
+        }
+        for(int c = lo; c <= hi && c < TOPO_MAX_CPUS; c++){
+            if(c >= 0) member[c] = 1;
+        }
+        ok = 1;
+        if(sep != ','){
+            break;
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Counts the distinct packages, NUMA nodes and physical cores of the CPUs
+ */
+static inline void topoCount(Topology *t){
+    t->npackages = t->nnodes = t->ncores = 0;
+    for(int i = 0; i < t->ncpus; i++){
+        const TopoCpu *cpu = &t->cpus[i];
+        int new_package = 1, new_node = 1, new_core = 1;
+        for(int j = 0; j < i; j++){
+            if(t->cpus[j].package == cpu->package){
+                new_package = 0;
+                if(t->cpus[j].core == cpu->core) new_core = 0;
+            }
+            if(t->cpus[j].node == cpu->node) new_node = 0;
+        }
+        t->npackages += new_package;
+        t->nnodes += new_node;
+        t->ncores += new_core;
+    }
+    t->numa = (t->nnodes > 1);
+}
+
+/**
+ * @brief Discovers the online CPUs and their topology
+ *
+ * Missing files are tolerated: without topology every CPU counts as a core
+ * of package 0, without NUMA information every CPU is on node 0.
+ *
+ * @param t Topology to fill
+ * @param root sysfs directory, normally "/sys/devices/system"
+ */
+static inline void topoProbe(Topology *t, const char *root){
+    static unsigned char online[TOPO_MAX_CPUS], in_node[TOPO_MAX_CPUS];
+    char path[512];
+
+    memset(online, 0, sizeof(online));
+    snprintf(path, sizeof(path), "%s/cpu/online", root);
+    if(!topoReadList(path, online)){
+        online[0] = 1;
+    }
+
+    t->ncpus = 0;
+    for(int c = 0; c < TOPO_MAX_CPUS; c++){
+        if(!online[c]){
+            continue;
+        }
+        TopoCpu *cpu = &t->cpus[t->ncpus++];
+        cpu->cpu = c;
+        snprintf(path, sizeof(path), "%s/cpu/cpu%d/topology/physical_package_id", root, c);
+        cpu->package = topoReadInt(path, 0);
+        snprintf(path, sizeof(path), "%s/cpu/cpu%d/topology/core_id", root, c);
+        cpu->core = topoReadInt(path, c);
+        cpu->node = 0;
+    }
+
+    // NUMA nodes list their CPUs
+    static unsigned char nodes[TOPO_MAX_CPUS];
+    memset(nodes, 0, sizeof(nodes));
+    snprintf(path, sizeof(path), "%s/node/online", root);
+    topoReadList(path, nodes);
+    for(int n = 0; n < TOPO_MAX_CPUS; n++){
+        memset(in_node, 0, sizeof(in_node));
+        snprintf(path, sizeof(path), "%s/node/node%d/cpulist", root, n);
+        if(!nodes[n] || !topoReadList(path, in_node)){
+            continue;
+        }
+        for(int i = 0; i < t->ncpus; i++){
+            if(in_node[t->cpus[i].cpu]){
+                t->cpus[i].node = n;
+            }
+        }
+    }
+
+    topoCount(t);
+}
+
+/**
+ * @brief Placement domain of a CPU: its NUMA node, or its package without NUMA
+ */
+static inline int topoDomainOf(const Topology *t, const TopoCpu *cpu){
+    return t->numa ? cpu->node : cpu->package;
+}
+
+/**
+ * @brief Computes the CPUs of a rank, physical cores first
+ *
+ * Domain d (in increasing order of domain id) goes to the local ranks r
+ * with r % ndomains == d; those ranks split its physical cores into
+ * contiguous shares.
+ *
+ * @param t Probed topology
+ * @param local_rank Rank within the node
+ * @param local_size Ranks on the node
+ * @param cpus Array of TOPO_MAX_CPUS to store the CPUs of the rank
+ * @param domain Pointer to store the domain id of the rank
+ * @param ncores Pointer to store the physical cores of the rank
+ * @return Number of CPUs stored
+ */
+static inline int topoRankCpus(const Topology *t, int local_rank, int local_size,
+                               int *cpus, int *domain, int *ncores){
+    static int domains[TOPO_MAX_CPUS], core_cpus[TOPO_MAX_CPUS][TOPO_MAX_SMT], core_smt[TOPO_MAX_CPUS];
+    static const TopoCpu *core_first[TOPO_MAX_CPUS];
+    int ndomains = 0;
+
+    // Domains in increasing order of id
+    for(int i = 0; i < t->ncpus; i++){
+        int d = topoDomainOf(t, &t->cpus[i]), pos = 0;
+        while(pos < ndomains && domains[pos] < d) pos++;
+        if(pos < ndomains && domains[pos] == d) continue;
+        memmove(domains + pos + 1, domains + pos, sizeof(int) * (ndomains - pos));
+        domains[pos] = d;
+        ndomains++;
+    }
+    *domain = domains[local_rank % ndomains];
+
+    // Physical cores of the domain, each with its hardware threads
+    int nc = 0;
+    for(int i = 0; i < t->ncpus; i++){
+        const TopoCpu *cpu = &t->cpus[i];
+        if(topoDomainOf(t, cpu) != *domain){
+            continue;
+        }
+        int c = 0;
+        while(c < nc && !(core_first[c]->package == cpu->package && core_first[c]->core == cpu->core)) c++;
+        if(c == nc){
+            core_first[nc] = cpu;
+            core_smt[nc++] = 0;
+        }
+        if(core_smt[c] < TOPO_MAX_SMT){
+            core_cpus[c][core_smt[c]++] = cpu->cpu;
+        }
+    }
+
+    // Contiguous share of the cores for each rank on this domain
+    int sharers = (local_size - 1 - local_rank % ndomains) / ndomains + 1;
+    int index = local_rank / ndomains;
+    int first = (int)((long)nc * index / sharers);
+    int last = (int)((long)nc * (index + 1) / sharers);
+    if(last == first){
+        // More ranks than cores: share one
+        last = first + 1;
+    }
+
+    int n = 0;
+    for(int s = 0; s < TOPO_MAX_SMT; s++){
+        for(int c = first; c < last; c++){
+            if(s < core_smt[c]){
+                cpus[n++] = core_cpus[c][s];
+            }
+        }
+    }
+    *ncores = last - first;
+    return n;
+}
+
+/**
+ * @brief Restricts the calling thread to a set of CPUs
+ *
+ * @return 1 on success, 0 if the OS refused (e.g. CPUs outside the cgroup)
+ */
+static inline int topoPin(const int *cpus, int n){
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int i = 0; i < n; i++){
+        CPU_SET(cpus[i], &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief Pins the calling thread to the index-th CPU of a rank's list
+ *
+ * @param cpus CPUs of the rank (see topoRankCpus)
+ * @param n Number of CPUs
+ * @param index Thread index (wraps around), or -1 for the whole list
+ * @return 1 on success, 0 if the OS refused
+ */
+static inline int topoPinThread(const int *cpus, int n, int index){
+    return (index < 0) ? topoPin(cpus, n) : topoPin(&cpus[index % n], 1);
+}
+
+#endif /* TOPOLOGY_H */
@@ -0,0 +1,321 @@
+/**
+ * @file trace.h
+ * @brief Timeline of a run in Chrome trace format (chrome://tracing, Perfetto)
+ *
+ * Every thread records its events into a ring buffer of its own: there is
+ * a single writer per ring, so recording takes no lock and no atomic. When
+ * a ring is full the oldest events are overwritten, so the end of the run
+ * (stop propagation, finalize) is always kept.
+ *
+ * Events are recorded per block of keys and per poll, never per key, and
+ * with tracing disabled every call returns on its first test. Timestamps
+ * come from CLOCK_MONOTONIC relative to a barrier at startup, so ranks of
+ * different nodes line up to within the barrier's skew.
+ *
+ * At the end rank 0 receives the rings of every rank in turn, in messages
+ * of at most TRACE_MSG_EVENTS events so no count overflows an int, and
+ * writes one JSON file: process = rank, thread = OpenMP thread.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <mpi.h>
+
+/** Events kept per thread */
+#define TRACE_RING_EVENTS (1L << 16)
+
+/** Events per message when the rings are sent to rank 0 */
+#define TRACE_MSG_EVENTS (1L << 20)
+
+/** Kinds of events */
+enum {
+    TRACE_SCHEDULE, /**< Span: fetching the next range of keys (args: range) */
+    TRACE_BLOCK,    /**< Span: a thread searching a block of keys (args: keys searched) */
+    TRACE_POLL,     /**< Span: MPI polling (stop signal, chunk requests, progress) */
+    TRACE_FOUND,    /**< Instant: candidate key found by this thread (arg: key) */
+    TRACE_STOP,     /**< Instant: stop seen by this rank (arg: stop value) */
+    TRACE_FINALIZE, /**< Span: stop propagation and cleanup after the search (arg: result) */
+    TRACE_KINDS
+};
+
+/** Names of the events in the trace */
+static const char *const trace_names[TRACE_KINDS] = {
+    "schedule", "block", "poll", "candidate found", "stop received", "finalize"
+};
+
+/**
+ * @brief One recorded event
+ */
+typedef struct {
+    double ts;   /**< Start, in microseconds since the startup barrier */
+    double dur;  /**< Duration in microseconds, or -1 for an instant event */
+    int kind;    /**< TRACE_* */
+    int tid;     /**< OpenMP thread */
+    long arg[2]; /**< Event arguments */
+} TraceEvent;
+
+/**
+ * @brief Events of one thread, alone in its cache lines
+ */
+typedef struct {
+    TraceEvent *events; /**< TRACE_RING_EVENTS slots */
+    long count;         /**< Events recorded, including overwritten ones */
+} __attribute__((aligned(64))) TraceRing;
+
+/**
+ * @brief Tracer of one rank
+ */
+typedef struct {
+    int enabled;
+    int comm_thread;  /**< Nonzero if thread 0 is a communication thread */
+    int nrings;
+    TraceRing *rings; /**< One ring per thread */
+    double epoch;     /**< CLOCK_MONOTONIC after the startup barrier, in microseconds */
+} Tracer;
+
+/**
+ * @brief Current CLOCK_MONOTONIC time in microseconds
+ */
+static inline double traceClock(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec * 1e-3;
+}
+
+/**
+ * @brief Sets up the rings of a rank (collective if enabled)
+ *
+ * @param t Tracer to initialize
+ * @param comm Communicator of the search
+ * @param enabled Zero to disable tracing
+ * @param nthreads Threads that record events
+ * @param comm_thread Nonzero if thread 0 is a communication thread
+ */
+static void traceInit(Tracer *t, MPI_Comm comm, int enabled, int nthreads, int comm_thread){
+    t->enabled = enabled;
+    t->comm_thread = comm_thread;
+    t->nrings = 0;
+    t->rings = NULL;
+    if(!enabled){
+        return;
+    }
+    t->rings = (TraceRing *)aligned_alloc(64, sizeof(TraceRing) * nthreads);
+    for(int i = 0; i < nthreads; i++){
+        t->rings[i].events = (TraceEvent *)malloc(sizeof(TraceEvent) * TRACE_RING_EVENTS);
+        t->rings[i].count = 0;
+        if(!t->rings[i].events){
+            printf("Error: Cannot allocate the trace buffers\n");
+            MPI_Abort(comm, 1);
+        }
+    }
+    t->nrings = nthreads;
+    MPI_Barrier(comm);
+    t->epoch = traceClock();
+}
+
+/**
+ * @brief Start time of a span, 0 when tracing is disabled
+ */
+static inline double traceNow(const Tracer *t){
+    return t->enabled ? traceClock() : 0;
+}
+
+/**
+ * @brief Records an event in the ring of thread tid
+ */
+static inline void traceRecord(Tracer *t, int tid, int kind, double ts, double dur, long arg0, long arg1){
+    TraceRing *ring = &t->rings[tid];
+    TraceEvent *e = &ring->events[ring->count++ % TRACE_RING_EVENTS];
+    e->ts = ts - t->epoch;
+    e->dur = dur;
+    e->kind = kind;
+    e->tid = tid;
+    e->arg[0] = arg0;
+    e->arg[1] = arg1;
+}
+
+/**
+ * @brief Records a span from start (see traceNow) until now
+ */
+static inline void traceSpan(Tracer *t, int tid, int kind, double start, long arg0, long arg1){
+    if(t->enabled){
+        traceRecord(t, tid, kind, start, traceClock() - start, arg0, arg1);
+    }
+}
+
+/**
+ * @brief Records an instant event
+ */
+static inline void traceInstant(Tracer *t, int tid, int kind, long arg){
+    if(t->enabled){
+        traceRecord(t, tid, kind, traceClock(), -1, arg, 0);
+    }
+}
+
+/**
+ * @brief Writes the arguments of an event as a JSON object
+ */
+static void traceWriteArgs(FILE *file, const TraceEvent *e){
+    switch(e->kind){
+    case TRACE_SCHEDULE:
+    case TRACE_BLOCK:
+        fprintf(file, "{\"lower\":%ld,\"upper\":%ld}", e->arg[0], e->arg[1]);
+        break;
+    case TRACE_FOUND:
+        fprintf(file, "{\"key\":%ld}", e->arg[0]);
+        break;
+    case TRACE_STOP:
+    case TRACE_FINALIZE:
+        fprintf(file, "{\"value\":%ld}", e->arg[0]);
+        break;
+    default:
+        fprintf(file, "{}");
+    }
+}
+
+/**
+ * @brief Writes the name records of a rank and its threads
+ */
+static void traceWriteNames(FILE *file, int rank, long nrings, long comm_thread, int first){
+    fprintf(file, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}",
+            first ? "" : ",\n", rank, rank);
+    for(int tid = 0; tid < nrings; tid++){
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                      "\"args\":{\"name\":\"%s %d\"}}",
+                rank, tid, (comm_thread && tid == 0) ? "communication thread" : "thread", tid);
+    }
+}
+
+/**
+ * @brief Writes n events of a rank
+ */
+static void traceWriteEvents(FILE *file, int rank, const TraceEvent *e, long n){
+    for(long i = 0; i < n; i++, e++){
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"search\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,",
+                trace_names[e->kind], rank, e->tid, e->ts);
+        if(e->dur < 0){
+            fprintf(file, "\"ph\":\"i\",\"s\":\"t\",\"args\":");
+        } else {
+            fprintf(file, "\"ph\":\"X\",\"dur\":%.3f,\"args\":", e->dur);
+        }
+        traceWriteArgs(file, e);
+        fputc('}', file);
+    }
+}
+
+/**
+ * @brief Sends the events of every rank to rank 0, which writes the trace (collective if enabled)
+ *
+ * Ranks are received one after the other, so rank 0 holds at most one
+ * message of events at a time however many ranks and threads there are.
+ * Releases the rings.
+ *
+ * @param t Tracer
+ * @param comm Communicator of the search
+ * @param path JSON file to write
+ */
+static void traceWrite(Tracer *t, MPI_Comm comm, const char *path){
+    if(!t->enabled){
+        return;
+    }
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    // The kept events of every ring, oldest first
+    long kept = 0, dropped = 0;
+    for(int i = 0; i < t->nrings; i++){
+        long count = t->rings[i].count;
+        kept += (count < TRACE_RING_EVENTS) ? count : TRACE_RING_EVENTS;
+        dropped += (count > TRACE_RING_EVENTS) ? count - TRACE_RING_EVENTS : 0;
+    }
+    TraceEvent *local = (TraceEvent *)malloc(sizeof(TraceEvent) * (kept + 1));
+    if(!local){
+        printf("Error: Cannot allocate the trace buffers\n");
+        MPI_Abort(comm, 1);
+    }
+    long n = 0;
+    for(int i = 0; i < t->nrings; i++){
+        TraceRing *ring = &t->rings[i];
+        long first = (ring->count > TRACE_RING_EVENTS) ? ring->count - TRACE_RING_EVENTS : 0;
+        for(long c = first; c < ring->count; c++){
+            local[n++] = ring->events[c % TRACE_RING_EVENTS];
+        }
+        free(ring->events);
+    }
+    free(t->rings);
+    t->rings = NULL;
+    t->enabled = 0;
+
+    // A duplicate communicator, so the messages never match any of the search.
+    // Events travel as bytes: every rank runs the same binary
+    MPI_Comm trace_comm;
+    MPI_Comm_dup(comm, &trace_comm);
+    long info[3] = { kept, t->nrings, t->comm_thread };
+    long *all_info = NULL;
+    long all_dropped = 0;
+    if(rank == 0){
+        all_info = (long *)malloc(sizeof(long) * 3 * size);
+    }
+    MPI_Gather(info, 3, MPI_LONG, all_info, 3, MPI_LONG, 0, trace_comm);
+    MPI_Reduce(&dropped, &all_dropped, 1, MPI_LONG, MPI_SUM, 0, trace_comm);
+
+    if(rank != 0){
+        for(long sent = 0; sent < kept; sent += TRACE_MSG_EVENTS){
+            long events = (kept - sent < TRACE_MSG_EVENTS) ? kept - sent : TRACE_MSG_EVENTS;
+            MPI_Send(local + sent, (int)(sizeof(TraceEvent) * events), MPI_BYTE, 0, 0, trace_comm);
+        }
+    } else {
+        // Keep receiving after a failed fopen, so the other ranks are not left blocked
+        FILE *file = fopen(path, "w");
+        TraceEvent *buf = (TraceEvent *)malloc(sizeof(TraceEvent) * TRACE_MSG_EVENTS);
+        if(!buf){
+            printf("Error: Cannot allocate the trace buffers\n");
+            MPI_Abort(comm, 1);
+        }
+        if(!file){
+            printf("Warning: Cannot write the trace to %s\n", path);
+        } else {
+            fprintf(file, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%ld},\"traceEvents\":[\n",
+                    all_dropped);
+        }
+        for(int r = 0; r < size; r++){
+            if(file){
+                traceWriteNames(file, r, all_info[3 * r + 1], all_info[3 * r + 2], r == 0);
+            }
+            if(r == 0){
+                if(file){
+                    traceWriteEvents(file, 0, local, kept);
+                }
+                continue;
+            }
+            for(long received = 0; received < all_info[3 * r]; received += TRACE_MSG_EVENTS){
+                long events = (all_info[3 * r] - received < TRACE_MSG_EVENTS) ?
+                              all_info[3 * r] - received : TRACE_MSG_EVENTS;
+                MPI_Recv(buf, (int)(sizeof(TraceEvent) * events), MPI_BYTE, r, 0, trace_comm, MPI_STATUS_IGNORE);
+                if(file){
+                    traceWriteEvents(file, r, buf, events);
+                }
+            }
+        }
+        if(file){
+            fprintf(file, "\n]}\n");
+            fclose(file);
+            printf("Trace written to %s", path);
+            if(all_dropped > 0){
+                printf(" (%ld oldest events overwritten)", all_dropped);
+            }
+            printf("\n");
+        }
+        free(buf);
+        free(all_info);
+    }
+    free(local);
+    MPI_Comm_free(&trace_comm);
+}
+
+#endif /* TRACE_H */
@@ -30,25 +30,30 @@ if [ ! -f "$TEST_FILE" ]; then
     exit 1
 fi
 
-# Función para ejecutar y extraer información
+# Función para ejecutar y extraer información del registro JSON de --results
+# (tiempo = búsqueda + parada)
 run_test() {
     local num_procs=$1
     local version=$2  # "normal" o "parallel"
+    local record="registro_$version.json"
     
+    rm -f "$record"
     if [ "$version" == "normal" ]; then
-        output=$(mpirun -np "$num_procs" ./main "$TEST_FILE" "$SEARCH_TEXT" 2>&1)
+        mpirun -np "$num_procs" ./main "$TEST_FILE" "$SEARCH_TEXT" --results "$record" > /dev/null 2>&1
     else
-        output=$(mpirun -np "$num_procs" ./main_parallel "$TEST_FILE" "$SEARCH_TEXT" 2>&1)
+        mpirun -np "$num_procs" ./main_parallel "$TEST_FILE" "$SEARCH_TEXT" --results "$record" > /dev/null 2>&1
     fi
     
-    tiempo=$(echo "$output" | grep -iE "(time|tiempo|elapsed)" | grep -oP '\d+\.\d+' | head -1)
-    
-    if [ -z "$tiempo" ]; then
-        tiempo=$(echo "$output" | grep -oP '\d+\.\d+' | head -1)
+    if [ ! -f "$record" ]; then
+        echo "||"
+        return
     fi
     
-    decrypted=$(echo "$output" | grep -i "Decrypted text:" | sed 's/.*Decrypted text: //')
-    key=$(echo "$output" | grep -i "Key found:" | grep -oP '\d+' | head -1)
+    tiempo=$(awk -v s="$(grep -oP '"time_search":\K[0-9.]+' "$record")" \
+                 -v p="$(grep -oP '"time_stop":\K[0-9.]+' "$record")" 'BEGIN { printf "%.6f", s + p }')
+    decrypted=$(grep -oP '"plaintext":"\K(\\.|[^"\\])*' "$record")
+    key=$(grep -oP '"key":\K\d+' "$record")
+    rm -f "$record"
     
     echo "$tiempo|$decrypted|$key"
 }
@@ -0,0 +1,165 @@
+/**
+ * @file workload.h
+ * @brief Synthetic workloads: encryption keys placed at chosen points of a rank's range
+ *
+ * How long a search takes depends on where the key falls in the range of
+ * the rank that finds it, so timings with an arbitrary key are not
+ * comparable. A placement names N ranks, a rank r and a fraction f: the
+ * key is the one at f of r's range when [0, 2^56) is split statically
+ * among N ranks, as program.c and program_parallel.c split it. Fraction 0
+ * is the first key r tests (best case), 1 its last one (worst case).
+ *
+ * Placements refer to the static split only: dynamic chunks, --calibrate
+ * and --complement change which rank meets which key.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Largest number of fractions of one --at list */
+#define WORKLOAD_MAX_FRACTIONS 64
+
+/** Rank value of a placement on every rank (--rank all) */
+#define WORKLOAD_ALL_RANKS (-1)
+
+/**
+ * @brief Key placement given with --ranks, --rank and --at
+ */
+typedef struct {
+    int ranks;         /**< Ranks of the split the placement refers to */
+    int rank;          /**< Rank whose range holds the key, or WORKLOAD_ALL_RANKS */
+    double fractions[WORKLOAD_MAX_FRACTIONS]; /**< Points of the range, in [0, 1] */
+    int nfractions;    /**< Number of fractions, 0 to keep the key of the input file */
+} WorkloadSpec;
+
+/**
+ * @brief Parses the placement options from argv[first] on
+ *
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param first Index of the first option
+ * @param ranks Default for --ranks, 0 to make it required with --at
+ * @param w Pointer to store the placement
+ * @param verbose Nonzero to print the reason of a failure
+ * @return 1 on success, 0 on an unknown or malformed option
+ */
+static inline int workloadParse(int argc, char *argv[], int first, int ranks, WorkloadSpec *w, int verbose){
+    w->ranks = ranks;
+    w->rank = 0;
+    w->nfractions = 0;
+
+    for(int i = first; i < argc; i++){
+        char *end;
+        if(strcmp(argv[i], "--ranks") == 0 && i + 1 < argc){
+            w->ranks = (int)strtol(argv[++i], &end, 10);
+            if(*end != 0 || w->ranks <= 0){
+                if(verbose) printf("Error: Invalid number of ranks %s\n", argv[i]);
+                return 0;
+            }
+        } else if(strcmp(argv[i], "--rank") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "all") == 0){
+                w->rank = WORKLOAD_ALL_RANKS;
+            } else {
+                w->rank = (int)strtol(argv[i], &end, 10);
+                if(*end != 0 || w->rank < 0){
+                    if(verbose) printf("Error: Invalid rank %s\n", argv[i]);
+                    return 0;
+                }
+            }
+        } else if(strcmp(argv[i], "--at") == 0 && i + 1 < argc){
+            // Comma-separated fractions, e.g. 0,0.5,1
+            const char *s = argv[++i];
+            w->nfractions = 0;
+            for(;;){
+                double f = strtod(s, &end);
+                if(end == s || f < 0 || f > 1 || w->nfractions == WORKLOAD_MAX_FRACTIONS){
+                    if(verbose) printf("Error: --at needs up to %d fractions in [0, 1]: %s\n",
+                                       WORKLOAD_MAX_FRACTIONS, argv[i]);
+                    return 0;
+                }
+                w->fractions[w->nfractions++] = f;
+                if(*end != ','){
+                    break;
+                }
+                s = end + 1;
+            }
+            if(*end != 0){
+                if(verbose) printf("Error: Malformed fraction list %s\n", argv[i]);
+                return 0;
+            }
+        } else {
+            if(verbose) printf("Error: Unknown option %s\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if(w->nfractions > 0 && w->ranks == 0){
+        if(verbose) printf("Error: --at needs --ranks <N>\n");
+        return 0;
+    }
+    if(w->nfractions > 0 && w->rank >= w->ranks){
+        if(verbose) printf("Error: Rank %d is outside a split among %d ranks\n", w->rank, w->ranks);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Range [lower, upper) of a rank when the keyspace is split statically
+ *
+ * @param keyspace Keys of the whole search
+ * @param N Number of ranks
+ * @param rank Rank
+ * @param lower Pointer to store the first key of the range
+ * @param upper Pointer to store the end of the range
+ */
+static inline void workloadRange(long keyspace, int N, int rank, long *lower, long *upper){
+    long range = keyspace / N;
+    *lower = range * rank;
+    *upper = (rank == N - 1) ? keyspace : range * (rank + 1);
+}
+
+/**
+ * @brief Key at a fraction of a rank's range
+ *
+ * @param keyspace Keys of the whole search
+ * @param N Number of ranks
+ * @param rank Rank
+ * @param fraction 0 for the first key of the range, 1 for the last one
+ * @return The key
+ */
+static inline long workloadKey(long keyspace, int N, int rank, double fraction){
+    long lower, upper;
+    workloadRange(keyspace, N, rank, &lower, &upper);
+    // long double: ranges exceed the 53-bit mantissa of a double
+    return lower + (long)(fraction * (long double)(upper - 1 - lower));
+}
+
+/**
+ * @brief Length of an output file name without its .bin extension
+ */
+static inline int workloadStem(const char *output){
+    int len = (int)strlen(output);
+    return (len > 4 && strcmp(output + len - 4, ".bin") == 0) ? len - 4 : len;
+}
+
+/**
+ * @brief File name of one key of a corpus: <output without .bin>_r<rank>_f<fraction>.bin
+ */
+static inline void workloadFileName(const char *output, int rank, double fraction, char *buf, size_t len){
+    snprintf(buf, len, "%.*s_r%d_f%g.bin", workloadStem(output), output, rank, fraction);
+}
+
+/**
+ * @brief File name of the list of keys of a corpus: <output without .bin>_keys.csv
+ */
+static inline void workloadManifestName(const char *output, char *buf, size_t len){
+    snprintf(buf, len, "%.*s_keys.csv", workloadStem(output), output);
+}
+
+#endif /* WORKLOAD_H */